@@ -0,0 +1,64 @@
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <string_view>
+#include <vector>
+#include "barnes_hut.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+
+// Compares the Barnes–Hut gravity with the exact O(n²) sum, for several opening angles.
+// Usage: BarnesHutBench [--count N] [--threads N]
+// The particles are spread in a few clusters, like they tend to be once gravity has been running for a while.
+
+namespace {
+
+auto make_particles(size_t count) -> std::vector<Particle>
+{
+    auto rng       = std::mt19937{42};
+    auto uniform   = std::uniform_real_distribution<float>{0.f, 1.f};
+    auto particles = std::vector<Particle>{};
+    particles.reserve(count);
+    auto const centers = std::vector<glm::vec2>{{-0.5f, -0.3f}, {0.4f, 0.5f}, {0.6f, -0.6f}, {0.f, 0.f}};
+    for (size_t i = 0; i < count; ++i)
+    {
+        float const angle  = 2.f * std::numbers::pi_v<float> * uniform(rng);
+        float const radius = 0.3f * std::sqrt(uniform(rng));
+        auto const position = centers[i % centers.size()] + radius * glm::vec2{std::cos(angle), std::sin(angle)};
+        particles.push_back({
+            .position          = position,
+            .previous_position = position,
+            .velocity          = {0.f, 0.f},
+            .elapsed           = 0.f,
+            .mass              = 0.5f + 1.5f * uniform(rng),
+            .age               = 0.f,
+            .life_time         = 1.f,
+        });
+    }
+    return particles;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    size_t count = 20000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (arg == "--count")
+            count = std::stoul(argv[i + 1]);
+        else if (arg == "--threads")
+            gl::set_threads_count(static_cast<unsigned int>(std::stoul(argv[i + 1])));
+    }
+
+    auto const particles = make_particles(count);
+    std::cout << std::format("{} particles, {} threads\n", count, gl::threads_count());
+    std::cout << std::format("{:>6} {:>12} {:>12} {:>12} {:>14}\n", "theta", "mean error", "max error", "tree (ms)", "brute (ms)");
+    for (float const theta : {0.f, 0.3f, 0.5f, 0.7f, 1.f})
+    {
+        auto const report = measure_gravity_accuracy(particles, {.theta = theta});
+        std::cout << std::format("{:>6.2f} {:>11.4f}% {:>11.4f}% {:>12.2f} {:>14.2f}\n", theta, 100.f * report.mean_relative_error, 100.f * report.max_relative_error, report.tree_milliseconds, report.brute_force_milliseconds);
+    }
+}
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include "bezier.hpp"
+#include "parametric.hpp"
+#include "poisson_disc.hpp"
+#include "rng.hpp"
+#include "utils.hpp"
+
+// Measures the math kernels of the demo, for several input sizes.
+// Usage: MathBench [--runs N] [--json results.json] [--baseline baseline.json] [--threshold 0.1]
+// --json saves the results, and a file saved that way can later be given to --baseline: each kernel is then compared with it,
+// and the program fails (returns 1) if one of them is slower than the baseline by more than the threshold (10% by default).
+
+namespace {
+
+struct Options {
+    int                                  runs_count{7};
+    std::optional<std::filesystem::path> json_path{};
+    std::optional<std::filesystem::path> baseline_path{};
+    double                               threshold{0.1};
+};
+
+auto parse_options(int argc, char** argv) -> Options
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (arg == "--runs" && i + 1 < argc)
+            options.runs_count = std::max(std::stoi(argv[++i]), 1);
+        else if (arg == "--json" && i + 1 < argc)
+            options.json_path = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc)
+            options.baseline_path = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc)
+            options.threshold = std::stod(argv[++i]);
+        else
+            std::cerr << std::format("Unknown option \"{}\"\n", arg);
+    }
+    return options;
+}
+
+struct Result {
+    std::string name;
+    size_t      size;
+    double      ns_per_item; /// Median over all the runs
+};
+
+/// Keeps the compiler from optimizing away the computations whose result is never used
+volatile float g_sink; // NOLINT(*avoid-non-const-global-variables)
+
+void consume(glm::vec2 v)
+{
+    g_sink = v.x + v.y;
+}
+
+/// `kernel(size)` must process `size` items
+auto measure(std::string name, size_t size, int runs_count, std::function<void(size_t)> const& kernel) -> Result
+{
+    kernel(size); // Warm up the caches
+    auto durations = std::vector<double>{};
+    for (int run = 0; run < runs_count; ++run)
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        kernel(size);
+        durations.push_back(std::chrono::duration<double, std::nano>{std::chrono::steady_clock::now() - begin}.count());
+    }
+    std::sort(durations.begin(), durations.end());
+    return {.name = std::move(name), .size = size, .ns_per_item = durations[durations.size() / 2] / static_cast<double>(size)};
+}
+
+auto run_all(int runs_count) -> std::vector<Result>
+{
+    auto const p0 = glm::vec2{-0.6f, 0.7f};
+    auto const p1 = glm::vec2{-0.2f, -0.2f};
+    auto const p2 = glm::vec2{0.3f, 0.8f};
+    auto const p3 = glm::vec2{0.8f, 0.3f};
+
+    auto results = std::vector<Result>{};
+    for (size_t const size : {size_t{1} << 10, size_t{1} << 14, size_t{1} << 18})
+    {
+        results.push_back(measure("bezier3_bernstein", size, runs_count, [&](size_t n) {
+            auto sum = glm::vec2{0.f};
+            for (size_t i = 0; i < n; ++i)
+                sum += bezier3_bernstein(p0, p1, p2, p3, static_cast<float>(i) / static_cast<float>(n));
+            consume(sum);
+        }));
+        results.push_back(measure("bezier3_tangent", size, runs_count, [&](size_t n) {
+            auto sum = glm::vec2{0.f};
+            for (size_t i = 0; i < n; ++i)
+                sum += bezier3_tangent(p0, p1, p2, p3, static_cast<float>(i) / static_cast<float>(n));
+            consume(sum);
+        }));
+        results.push_back(measure("sample_parametric", size, runs_count, [&](size_t n) {
+            auto const points = sample_parametric([&](float t) { return bezier3_bernstein(p0, p1, p2, p3, t); }, static_cast<int>(n));
+            consume(points.back());
+        }));
+        results.push_back(measure("utils::rand", size, runs_count, [&](size_t n) {
+            float sum = 0.f;
+            for (size_t i = 0; i < n; ++i)
+                sum += utils::rand(0.f, 1.f);
+            consume(glm::vec2{sum});
+        }));
+        auto values = std::vector<float>(size);
+        auto stream = rng::Stream{0};
+        results.push_back(measure("rng::Stream::fill_uniform", size, runs_count, [&](size_t n) {
+            stream.fill_uniform(std::span{values}.first(n), 0.f, 1.f);
+            consume(glm::vec2{values[n - 1]});
+        }));
+    }
+
+    for (size_t const size : {size_t{256}, size_t{4096}, size_t{65536}})
+    {
+        auto positions = std::vector<glm::vec2>(size);
+        rng::Stream{1}.fill_uniform({reinterpret_cast<float*>(positions.data()), 2 * size}, -1.f, 1.f); // NOLINT(*reinterpret-cast)
+        results.push_back(measure("findClosestT", size, runs_count, [&](size_t n) {
+            float sum = 0.f;
+            for (size_t i = 0; i < n; ++i)
+                sum += findClosestT(p0, p1, p2, p3, positions[i]);
+            consume(glm::vec2{sum});
+        }));
+    }
+
+    // The size is the expected number of points: a disc of radius r/2 around each point, and they cover about 70% of the unit square
+    for (size_t const size : {size_t{100}, size_t{1000}, size_t{10000}})
+    {
+        float const radius = std::sqrt(0.7f * 4.f / (glm::pi<float>() * static_cast<float>(size)));
+        results.push_back(measure("PoissonDisc::GeneratePoints", size, runs_count, [&](size_t) {
+            auto const points = PoissonDisc::GeneratePoints(radius, glm::vec2{1.f});
+            consume(points.back());
+        }));
+    }
+    return results;
+}
+
+void save_json(std::filesystem::path const& path, std::vector<Result> const& results)
+{
+    auto file = std::ofstream{path};
+    file << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto const& result = results[i];
+        file << std::format("    {{\"name\": \"{}\", \"size\": {}, \"ns_per_item\": {:.4f}}}{}\n", result.name, result.size, result.ns_per_item, i + 1 < results.size() ? "," : "");
+    }
+    file << "  ]\n}\n";
+    if (!file)
+        std::cerr << std::format("Failed to write \"{}\"\n", path.string());
+}
+
+/// Returns the text after `"key": `, up to the next comma, quote or brace
+auto json_value(std::string_view line, std::string_view key) -> std::optional<std::string_view>
+{
+    auto const pattern = std::format("\"{}\": ", key);
+    auto       begin   = line.find(pattern);
+    if (begin == std::string_view::npos)
+        return std::nullopt;
+    begin += pattern.size();
+    if (line[begin] == '"')
+        return line.substr(begin + 1, line.find('"', begin + 1) - begin - 1);
+    return line.substr(begin, line.find_first_of(",}", begin) - begin);
+}
+
+/// Only reads the files written by save_json(): one benchmark per line
+auto load_json(std::filesystem::path const& path) -> std::vector<Result>
+{
+    auto file    = std::ifstream{path};
+    auto results = std::vector<Result>{};
+    auto line    = std::string{};
+    while (std::getline(file, line))
+    {
+        auto const name        = json_value(line, "name");
+        auto const size        = json_value(line, "size");
+        auto const ns_per_item = json_value(line, "ns_per_item");
+        if (name && size && ns_per_item)
+            results.push_back({.name = std::string{*name}, .size = std::stoul(std::string{*size}), .ns_per_item = std::stod(std::string{*ns_per_item})});
+    }
+    return results;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const options = parse_options(argc, argv);
+    rng::set_global_seed(42);
+
+    auto const results  = run_all(options.runs_count);
+    auto const baseline = options.baseline_path ? load_json(*options.baseline_path) : std::vector<Result>{};
+    if (options.baseline_path && baseline.empty())
+        std::cerr << std::format("Could not read any result from the baseline \"{}\"\n", options.baseline_path->string());
+
+    bool has_regressed = false;
+    std::cout << std::format("{:<28} {:>8} {:>12} {:>12} {:>9}\n", "kernel", "size", "ns / item", "baseline", "change");
+    for (auto const& result : results)
+    {
+        auto const reference = std::find_if(baseline.begin(), baseline.end(), [&](Result const& other) {
+            return other.name == result.name && other.size == result.size;
+        });
+        if (reference == baseline.end())
+        {
+            std::cout << std::format("{:<28} {:>8} {:>12.3f}\n", result.name, result.size, result.ns_per_item);
+            continue;
+        }
+        double const change    = result.ns_per_item / reference->ns_per_item - 1.;
+        bool const   regressed = change > options.threshold;
+        has_regressed |= regressed;
+        std::cout << std::format("{:<28} {:>8} {:>12.3f} {:>12.3f} {:>+8.1f}%{}\n", result.name, result.size, result.ns_per_item, reference->ns_per_item, 100. * change, regressed ? "  REGRESSION" : "");
+    }
+
+    if (options.json_path)
+        save_json(*options.json_path, results);
+    return has_regressed ? 1 : 0;
+}
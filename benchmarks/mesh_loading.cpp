@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <string_view>
+#include <vector>
+#include "opengl-framework/opengl-framework.hpp"
+
+// Compares the classic and the multithreaded .obj parsers of gl::load_mesh_data(), and checks that they produce the same MeshData.
+// Usage: MeshLoadingBench [--threads N] [--runs N] [--size N] [files.obj...]
+// Without any file, a big torus (with N*N quads, 1000 by default) is generated in the temporary directory and used instead.
+
+namespace {
+
+struct Options {
+    unsigned int                       threads_count{0};
+    int                                runs_count{5};
+    int                                torus_size{1000};
+    std::vector<std::filesystem::path> files{};
+};
+
+auto parse_options(int argc, char** argv) -> Options
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (arg == "--threads" && i + 1 < argc)
+            options.threads_count = static_cast<unsigned int>(std::stoul(argv[++i]));
+        else if (arg == "--runs" && i + 1 < argc)
+            options.runs_count = std::max(std::stoi(argv[++i]), 1);
+        else if (arg == "--size" && i + 1 < argc)
+            options.torus_size = std::max(std::stoi(argv[++i]), 3);
+        else
+            options.files.emplace_back(arg);
+    }
+    return options;
+}
+
+/// Writes a torus made of size*size quads, with positions, normals and UVs
+auto generate_torus(int size) -> std::filesystem::path
+{
+    auto const path = std::filesystem::temp_directory_path() / std::format("mesh_loading_bench_torus_{}.obj", size);
+    if (std::filesystem::exists(path))
+        return path;
+
+    auto file = std::ofstream{path};
+    for (int i = 0; i < size; ++i)
+    {
+        for (int j = 0; j < size; ++j)
+        {
+            float const u = 2.f * std::numbers::pi_v<float> * static_cast<float>(i) / static_cast<float>(size);
+            float const v = 2.f * std::numbers::pi_v<float> * static_cast<float>(j) / static_cast<float>(size);
+            file << std::format("v {} {} {}\n", (1.f + 0.3f * std::cos(v)) * std::cos(u), (1.f + 0.3f * std::cos(v)) * std::sin(u), 0.3f * std::sin(v));
+            file << std::format("vn {} {} {}\n", std::cos(v) * std::cos(u), std::cos(v) * std::sin(u), std::sin(v));
+            file << std::format("vt {} {}\n", static_cast<float>(i) / static_cast<float>(size), static_cast<float>(j) / static_cast<float>(size));
+        }
+    }
+    auto const corner = [&](int i, int j) {
+        int const index = (i % size) * size + (j % size) + 1;
+        return std::format("{0}/{0}/{0}", index);
+    };
+    for (int i = 0; i < size; ++i)
+    {
+        for (int j = 0; j < size; ++j)
+            file << "f " << corner(i, j) << ' ' << corner(i + 1, j) << ' ' << corner(i + 1, j + 1) << ' ' << corner(i, j + 1) << '\n';
+    }
+    return path;
+}
+
+/// Returns the median duration, in milliseconds, and the result of the last run
+auto measure(std::filesystem::path const& path, gl::LoadMesh_Options const& options, int runs_count) -> std::pair<double, gl::MeshData>
+{
+    auto durations = std::vector<double>{};
+    auto data      = gl::MeshData{};
+    for (int run = 0; run < runs_count; ++run)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        data             = gl::load_mesh_data(path, options);
+        durations.push_back(std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count());
+    }
+    std::sort(durations.begin(), durations.end());
+    return {durations[durations.size() / 2], std::move(data)};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto options = parse_options(argc, argv);
+    if (options.files.empty())
+        options.files.push_back(generate_torus(options.torus_size));
+
+    int mismatches_count = 0;
+    for (auto const& path : options.files)
+    {
+        auto const file_size                     = static_cast<double>(std::filesystem::file_size(path)) / (1024. * 1024.);
+        auto const [classic_ms, classic]         = measure(path, {.log_stats = false, .multithreaded = false, .optimize = false}, options.runs_count);
+        auto const [multithreaded_ms, threaded] = measure(path, {.log_stats = false, .multithreaded = true, .threads_count = options.threads_count, .optimize = false}, options.runs_count);
+        bool const same_output                   = classic.vertices == threaded.vertices && classic.indices == threaded.indices;
+        if (!same_output)
+            ++mismatches_count;
+
+        std::cout << std::format("{} ({:.1f} MB, {} vertices, {} triangles)\n", path.string(), file_size, classic.vertices_count(), classic.indices.size() / 3);
+        std::cout << std::format("    classic       : {:8.2f} ms ({:.1f} MB/s)\n", classic_ms, file_size / classic_ms * 1000.);
+        std::cout << std::format("    multithreaded : {:8.2f} ms ({:.1f} MB/s), x{:.2f}\n", multithreaded_ms, file_size / multithreaded_ms * 1000., classic_ms / multithreaded_ms);
+        std::cout << (same_output ? "    Both parsers produced the same mesh.\n" : "    ERROR: the parsers produced different meshes!\n");
+    }
+    return mismatches_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <string_view>
+#include <vector>
+#include "opengl-framework/opengl-framework.hpp"
+#include "rng.hpp"
+#include "simulation.hpp"
+
+// Runs the simulation of the demo (forces, Bézier field, collisions, respawn...) without any window, and measures how long each step takes.
+// Usage: ParticlesBench [--count N] [--frames N] [--warmup N] [--threads N] [--seed N] [--no-n-body]
+
+namespace {
+
+struct Options {
+    size_t       particles_count{100'000};
+    int          frames_count{600};
+    int          warmup_frames_count{60}; /// Not measured, they let the pool reach its steady state
+    unsigned int threads_count{0};
+    uint64_t     seed{42};
+    bool         n_body{true};
+};
+
+auto parse_options(int argc, char** argv) -> Options
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (arg == "--count" && i + 1 < argc)
+            options.particles_count = std::stoul(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc)
+            options.frames_count = std::max(std::stoi(argv[++i]), 1);
+        else if (arg == "--warmup" && i + 1 < argc)
+            options.warmup_frames_count = std::max(std::stoi(argv[++i]), 0);
+        else if (arg == "--threads" && i + 1 < argc)
+            options.threads_count = static_cast<unsigned int>(std::stoul(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            options.seed = std::stoull(argv[++i]);
+        else if (arg == "--no-n-body")
+            options.n_body = false;
+        else
+            std::cerr << std::format("Unknown option \"{}\"\n", arg);
+    }
+    return options;
+}
+
+auto percentile(std::vector<double> const& sorted_values, double p) -> double
+{
+    auto const index = static_cast<size_t>(p * static_cast<double>(sorted_values.size() - 1) + 0.5);
+    return sorted_values[index];
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const options = parse_options(argc, argv);
+    if (options.threads_count != 0)
+        gl::set_threads_count(options.threads_count);
+    rng::set_global_seed(options.seed);
+
+    auto simulation = Simulation{{.particles_count = options.particles_count, .n_body = options.n_body}};
+    auto const curve = std::array<glm::vec2, 4>{{{-0.6f, 0.7f}, {-0.2f, -0.2f}, {0.3f, 0.8f}, {0.8f, 0.3f}}};
+    float const dt   = 1.f / 120.f;
+
+    for (int frame = 0; frame < options.warmup_frames_count; ++frame)
+        simulation.step(dt, curve);
+
+    auto   durations       = std::vector<double>{}; // In milliseconds
+    size_t particles_steps = 0;
+    durations.reserve(static_cast<size_t>(options.frames_count));
+    for (int frame = 0; frame < options.frames_count; ++frame)
+    {
+        particles_steps += simulation.particles().size();
+        auto const begin = std::chrono::steady_clock::now();
+        simulation.step(dt, curve);
+        durations.push_back(std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - begin}.count());
+    }
+
+    double const total_ms = std::accumulate(durations.begin(), durations.end(), 0.);
+    std::sort(durations.begin(), durations.end());
+    std::cout << std::format("{} particles (max), {} frames, {} threads, seed {}{}\n", options.particles_count, options.frames_count, gl::threads_count(), options.seed, options.n_body ? "" : ", no n-body");
+    std::cout << std::format("{:>22} {:>10.3f}\n", "ns / particle / step", total_ms * 1e6 / static_cast<double>(particles_steps));
+    std::cout << std::format("{:>22} {:>10.3f}\n", "M particles / second", static_cast<double>(particles_steps) / total_ms / 1e3);
+    std::cout << std::format("{:>22} {:>10.3f}\n", "mean step (ms)", total_ms / static_cast<double>(durations.size()));
+    for (double const p : {0.5, 0.9, 0.99})
+        std::cout << std::format("{:>22} {:>10.3f}\n", std::format("p{} step (ms)", static_cast<int>(p * 100.)), percentile(durations, p));
+    std::cout << std::format("{:>22} {:>10.3f}\n", "max step (ms)", durations.back());
+}
@@ -1,12 +1,24 @@
 #pragma once
 #include <string_view>
+#include "../../src/Bvh.hpp"
 #include "../../src/Camera.hpp"
+#include "../../src/CompressedTexture.hpp"
+#include "../../src/DrawBatch.hpp"
 #include "../../src/EventsCallbacks.hpp"
+#include "../../src/FixedTimestep.hpp"
 #include "../../src/Mesh.hpp"
+#include "../../src/MeshPool.hpp"
 #include "../../src/RenderTarget.hpp"
 #include "../../src/Shader.hpp"
 #include "../../src/Texture.hpp"
+#include "../../src/TextureArray.hpp"
+#include "../../src/TextureAtlas.hpp"
+#include "../../src/bounds.hpp"
+#include "../../src/culling.hpp"
+#include "../../src/handle_error.hpp"
+#include "../../src/load_mesh.hpp"
 #include "../../src/make_absolute_path.hpp"
+#include "../../src/parallel_for.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 #include "tiny_obj_loader.h"
@@ -0,0 +1,456 @@
+#include "Bvh.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <iterator>
+#include "handle_error.hpp"
+#include "parallel_for.hpp"
+
+namespace gl {
+
+namespace {
+
+auto empty_box() -> BoundingBox
+{
+    return {.min = glm::vec3{std::numeric_limits<float>::infinity()}, .max = glm::vec3{-std::numeric_limits<float>::infinity()}};
+}
+
+auto merge(BoundingBox const& a, BoundingBox const& b) -> BoundingBox
+{
+    return {.min = glm::min(a.min, b.min), .max = glm::max(a.max, b.max)};
+}
+
+auto half_area(BoundingBox const& box) -> float
+{
+    auto const size = box.max - box.min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+/// Past this depth, we split at the median instead of using the SAH, so that the depth of the tree stays below the size of the traversal stacks
+constexpr size_t max_sah_depth   = 32;
+constexpr size_t traversal_stack = 64;
+
+struct BuildData {
+    std::vector<BoundingBox> triangles_bounds{};
+    std::vector<glm::vec3>   centroids{};
+    std::vector<uint32_t>    triangles{}; /// Reordered during the build, so that the triangles of each node are contiguous
+    Bvh_Options              options{};
+};
+
+/// A subtree whose construction has been deferred, so that it can run in parallel with the other ones
+struct BuildTask {
+    size_t node_index{};
+    size_t begin{};
+    size_t end{};
+    size_t depth{};
+};
+
+/// Partitions the triangles of [begin, end), and returns the position of the partition, or std::nullopt if they should stay in a single leaf
+auto split(BuildData& data, size_t begin, size_t end, size_t depth) -> std::optional<size_t>
+{
+    if (end - begin <= data.options.max_triangles_per_leaf)
+        return std::nullopt;
+
+    auto centroids_box = empty_box();
+    for (size_t i = begin; i < end; ++i)
+        centroids_box = merge(centroids_box, {.min = data.centroids[data.triangles[i]], .max = data.centroids[data.triangles[i]]});
+    auto const triangles = std::span{data.triangles}.subspan(begin, end - begin);
+
+    auto const split_at_median = [&](glm::length_t axis) {
+        auto const middle = triangles.begin() + static_cast<std::ptrdiff_t>(triangles.size() / 2);
+        std::nth_element(triangles.begin(), middle, triangles.end(), [&](uint32_t a, uint32_t b) {
+            return data.centroids[a][axis] < data.centroids[b][axis];
+        });
+        return begin + triangles.size() / 2;
+    };
+    auto const extent       = centroids_box.max - centroids_box.min;
+    auto const longest_axis = static_cast<glm::length_t>(extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2));
+    if (extent[longest_axis] <= 0.f)
+        return std::nullopt; // All the centroids are at the same position, no plane can separate them
+    if (depth >= max_sah_depth)
+        return split_at_median(longest_axis);
+
+    struct Bin {
+        BoundingBox box{empty_box()};
+        size_t      count{0};
+    };
+    size_t const bins_count = data.options.bins_count;
+    auto         bins       = std::vector<Bin>(bins_count);
+    auto         left_areas = std::vector<float>(bins_count);
+    float        best_cost  = std::numeric_limits<float>::infinity();
+    auto         best_axis  = glm::length_t{0};
+    size_t       best_bin   = 0; /// The triangles in the bins before best_bin go to the left child
+    auto const   bin_index  = [&](glm::length_t axis, uint32_t triangle) {
+        float const scale = static_cast<float>(bins_count) / extent[axis];
+        return std::min(static_cast<size_t>((data.centroids[triangle][axis] - centroids_box.min[axis]) * scale), bins_count - 1);
+    };
+
+    for (glm::length_t axis = 0; axis < 3; ++axis)
+    {
+        if (extent[axis] <= 0.f)
+            continue;
+        std::fill(bins.begin(), bins.end(), Bin{});
+        for (uint32_t const triangle : triangles)
+        {
+            auto& bin = bins[bin_index(axis, triangle)];
+            bin.box   = merge(bin.box, data.triangles_bounds[triangle]);
+            bin.count++;
+        }
+
+        // Sweep from the left to get the area of the left side of each plane, then from the right to evaluate the SAH cost of each plane
+        auto left_box = empty_box();
+        for (size_t i = 0; i + 1 < bins_count; ++i)
+        {
+            left_box      = merge(left_box, bins[i].box);
+            left_areas[i] = half_area(left_box);
+        }
+        auto   right_box   = empty_box();
+        size_t right_count = 0;
+        size_t left_count  = triangles.size();
+        for (size_t i = bins_count - 1; i > 0; --i)
+        {
+            right_box = merge(right_box, bins[i].box);
+            right_count += bins[i].count;
+            left_count -= bins[i].count;
+            if (left_count == 0 || right_count == 0)
+                continue;
+            float const cost = static_cast<float>(left_count) * left_areas[i - 1] + static_cast<float>(right_count) * half_area(right_box);
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin  = i;
+            }
+        }
+    }
+
+    auto const middle = std::partition(triangles.begin(), triangles.end(), [&](uint32_t triangle) {
+        return bin_index(best_axis, triangle) < best_bin;
+    });
+    if (middle == triangles.begin() || middle == triangles.end())
+        return split_at_median(longest_axis);
+    return begin + static_cast<size_t>(middle - triangles.begin());
+}
+
+/// Builds the subtree of `node_index`. If `tasks` is provided, the subtrees that contain fewer than `task_size` triangles are not built, but added to the tasks instead.
+void build(BuildData& data, std::vector<Bvh::Node>& nodes, size_t node_index, size_t begin, size_t end, size_t depth, std::vector<BuildTask>* tasks = nullptr, size_t task_size = 0)
+{
+    auto box = empty_box();
+    for (size_t i = begin; i < end; ++i)
+        box = merge(box, data.triangles_bounds[data.triangles[i]]);
+    nodes[node_index].min = box.min;
+    nodes[node_index].max = box.max;
+
+    if (tasks != nullptr && end - begin <= task_size)
+    {
+        tasks->push_back({.node_index = node_index, .begin = begin, .end = end, .depth = depth});
+        return;
+    }
+
+    auto const middle = split(data, begin, end, depth);
+    if (!middle)
+    {
+        nodes[node_index].first           = static_cast<uint32_t>(begin);
+        nodes[node_index].triangles_count = static_cast<uint32_t>(end - begin);
+        return;
+    }
+    size_t const first_child          = nodes.size();
+    nodes[node_index].first           = static_cast<uint32_t>(first_child);
+    nodes[node_index].triangles_count = 0;
+    nodes.emplace_back();
+    nodes.emplace_back();
+    build(data, nodes, first_child, begin, *middle, depth + 1, tasks, task_size);
+    build(data, nodes, first_child + 1, *middle, end, depth + 1, tasks, task_size);
+}
+
+/// Returns the distance at which the ray enters the box, or infinity if it misses it, or enters it after max_distance
+auto intersect_box(Bvh::Node const& node, glm::vec3 const& origin, glm::vec3 const& inverse_direction, float max_distance) -> float
+{
+    auto const t0    = (node.min - origin) * inverse_direction;
+    auto const t1    = (node.max - origin) * inverse_direction;
+    auto const t_min = glm::min(t0, t1);
+    auto const t_max = glm::max(t0, t1);
+    float const near = std::max({t_min.x, t_min.y, t_min.z, 0.f});
+    float const far  = std::min({t_max.x, t_max.y, t_max.z, max_distance});
+    return near <= far ? near : std::numeric_limits<float>::infinity();
+}
+
+/// Möller and Trumbore, "Fast, Minimum Storage Ray/Triangle Intersection", 1997. Both sides of the triangle are hit.
+auto intersect_triangle(Bvh::Triangle const& triangle, Ray const& ray, float max_distance) -> std::optional<RayHit>
+{
+    auto const  edge1       = triangle.vertices[1] - triangle.vertices[0];
+    auto const  edge2       = triangle.vertices[2] - triangle.vertices[0];
+    auto const  p           = glm::cross(ray.direction, edge2);
+    float const determinant = glm::dot(edge1, p);
+    if (std::abs(determinant) < 1e-12f)
+        return std::nullopt; // The ray is parallel to the triangle
+    float const inverse_determinant = 1.f / determinant;
+    auto const  s                   = ray.origin - triangle.vertices[0];
+    float const u                   = glm::dot(s, p) * inverse_determinant;
+    if (u < 0.f || u > 1.f)
+        return std::nullopt;
+    auto const  q = glm::cross(s, edge1);
+    float const v = glm::dot(ray.direction, q) * inverse_determinant;
+    if (v < 0.f || u + v > 1.f)
+        return std::nullopt;
+    float const distance = glm::dot(edge2, q) * inverse_determinant;
+    if (distance < 0.f || distance > max_distance)
+        return std::nullopt;
+    return RayHit{.distance = distance, .triangle_index = triangle.index, .barycentrics = {u, v}};
+}
+
+auto distance_squared(Bvh::Node const& node, glm::vec3 const& point) -> float
+{
+    auto const delta = glm::max(glm::max(node.min - point, point - node.max), glm::vec3{0.f});
+    return glm::dot(delta, delta);
+}
+
+/// Ericson, "Real-Time Collision Detection", section 5.1.5
+auto closest_point_on_triangle(glm::vec3 const& p, glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c) -> glm::vec3
+{
+    auto const  ab = b - a;
+    auto const  ac = c - a;
+    auto const  ap = p - a;
+    float const d1 = glm::dot(ab, ap);
+    float const d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f)
+        return a;
+
+    auto const  bp = p - b;
+    float const d3 = glm::dot(ab, bp);
+    float const d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3)
+        return b;
+
+    float const vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+        return a + d1 / (d1 - d3) * ab;
+
+    auto const  cp = p - c;
+    float const d5 = glm::dot(ab, cp);
+    float const d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6)
+        return c;
+
+    float const vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+        return a + d2 / (d2 - d6) * ac;
+
+    float const va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+        return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+
+    float const denominator = 1.f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+auto positions_of(MeshData const& mesh) -> std::vector<glm::vec3>
+{
+    auto const members  = internal::vertex_members(mesh.layout);
+    auto const position = std::find_if(members.begin(), members.end(), [](VertexMember const& member) {
+        return member.location == 0 && member.type == GL_FLOAT && member.components_count == 3;
+    });
+    if (position == members.end())
+        handle_error("[Bvh] The mesh must have a Position3D at location 0.");
+
+    size_t const offset = position->offset / sizeof(float);
+    size_t const stride = mesh.floats_per_vertex();
+    auto         res    = std::vector<glm::vec3>(mesh.vertices_count());
+    for (size_t i = 0; i < res.size(); ++i)
+        res[i] = {mesh.vertices[i * stride + offset], mesh.vertices[i * stride + offset + 1], mesh.vertices[i * stride + offset + 2]};
+    return res;
+}
+
+} // namespace
+
+Bvh::Bvh(MeshData const& mesh, Bvh_Options const& options)
+    : Bvh{positions_of(mesh), mesh.indices, options}
+{}
+
+Bvh::Bvh(std::span<glm::vec3 const> positions, std::span<uint32_t const> indices, Bvh_Options const& options)
+{
+    assert(indices.size() % 3 == 0 && "You must provide 3 indices for each triangle");
+    assert(options.bins_count >= 2 && options.max_triangles_per_leaf >= 1);
+    size_t const triangles_count = indices.size() / 3;
+    if (triangles_count == 0)
+        return;
+    if (triangles_count > std::numeric_limits<uint32_t>::max())
+        handle_error(std::format("[Bvh] Too many triangles ({}).", triangles_count));
+
+    auto data = BuildData{
+        .triangles_bounds = std::vector<BoundingBox>(triangles_count),
+        .centroids        = std::vector<glm::vec3>(triangles_count),
+        .triangles        = std::vector<uint32_t>(triangles_count),
+        .options          = options,
+    };
+    parallel_for(triangles_count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto const& a            = positions[indices[3 * i]];
+            auto const& b            = positions[indices[3 * i + 1]];
+            auto const& c            = positions[indices[3 * i + 2]];
+            data.triangles_bounds[i] = {.min = glm::min(a, glm::min(b, c)), .max = glm::max(a, glm::max(b, c))};
+            data.centroids[i]        = (a + b + c) / 3.f;
+            data.triangles[i]        = static_cast<uint32_t>(i);
+        }
+    });
+
+    _nodes.reserve(2 * triangles_count / options.max_triangles_per_leaf + 1);
+    _nodes.emplace_back();
+    if (triangles_count < options.parallel_threshold || threads_count() <= 1)
+    {
+        build(data, _nodes, 0, 0, triangles_count, 0);
+    }
+    else
+    {
+        // Build the top of the tree on this thread, until the subtrees are small enough to give a few of them to each thread
+        auto tasks = std::vector<BuildTask>{};
+        build(data, _nodes, 0, 0, triangles_count, 0, &tasks, std::max<size_t>(triangles_count / (threads_count() * 8), 1024));
+
+        auto subtrees = std::vector<std::vector<Node>>(tasks.size());
+        parallel_for(tasks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                subtrees[i].emplace_back();
+                build(data, subtrees[i], 0, tasks[i].begin, tasks[i].end, tasks[i].depth);
+            }
+        });
+
+        // Append the subtrees. Their root replaces the node that was waiting for them, and the other nodes are shifted.
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            auto const& subtree = subtrees[i];
+            auto const  shift   = static_cast<uint32_t>(_nodes.size() - 1);
+            auto const  rebase  = [&](Node node) {
+                if (node.triangles_count == 0)
+                    node.first += shift;
+                return node;
+            };
+            _nodes[tasks[i].node_index] = rebase(subtree[0]);
+            std::transform(subtree.begin() + 1, subtree.end(), std::back_inserter(_nodes), rebase);
+        }
+    }
+
+    _triangles.resize(triangles_count);
+    parallel_for(triangles_count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t const triangle = data.triangles[i];
+            _triangles[i]           = Triangle{
+                .vertices = {positions[indices[3 * triangle]], positions[indices[3 * triangle + 1]], positions[indices[3 * triangle + 2]]},
+                .index    = triangle,
+            };
+        }
+    });
+}
+
+auto Bvh::bounds() const -> BoundingBox
+{
+    if (_nodes.empty())
+        return {};
+    return {.min = _nodes[0].min, .max = _nodes[0].max};
+}
+
+auto Bvh::intersect(Ray const& ray, float max_distance) const -> std::optional<RayHit>
+{
+    if (_nodes.empty())
+        return std::nullopt;
+
+    auto const inverse_direction = 1.f / ray.direction;
+    auto       res               = std::optional<RayHit>{};
+
+    struct StackEntry {
+        uint32_t node;
+        float    distance;
+    };
+    auto   stack      = std::array<StackEntry, traversal_stack>{};
+    size_t stack_size = 0;
+    if (float const distance = intersect_box(_nodes[0], ray.origin, inverse_direction, max_distance); distance != std::numeric_limits<float>::infinity())
+        stack[stack_size++] = {0, distance};
+
+    while (stack_size > 0)
+    {
+        auto const entry = stack[--stack_size];
+        if (entry.distance > max_distance)
+            continue; // We found a closer hit since this node was pushed
+        auto const& node = _nodes[entry.node];
+        if (node.triangles_count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.triangles_count; ++i)
+            {
+                if (auto const hit = intersect_triangle(_triangles[i], ray, max_distance))
+                {
+                    res          = hit;
+                    max_distance = hit->distance;
+                }
+            }
+            continue;
+        }
+
+        // Push the furthest child first, so that the closest one is visited first
+        auto near = StackEntry{node.first, intersect_box(_nodes[node.first], ray.origin, inverse_direction, max_distance)};
+        auto far  = StackEntry{node.first + 1, intersect_box(_nodes[node.first + 1], ray.origin, inverse_direction, max_distance)};
+        if (far.distance < near.distance)
+            std::swap(near, far);
+        assert(stack_size + 2 <= stack.size());
+        if (far.distance != std::numeric_limits<float>::infinity())
+            stack[stack_size++] = far;
+        if (near.distance != std::numeric_limits<float>::infinity())
+            stack[stack_size++] = near;
+    }
+    return res;
+}
+
+auto Bvh::closest_point(glm::vec3 const& point, float max_distance) const -> std::optional<ClosestPoint>
+{
+    if (_nodes.empty())
+        return std::nullopt;
+
+    auto  res                  = std::optional<ClosestPoint>{};
+    float max_distance_squared = max_distance * max_distance;
+
+    struct StackEntry {
+        uint32_t node;
+        float    distance_squared;
+    };
+    auto   stack      = std::array<StackEntry, traversal_stack>{};
+    size_t stack_size = 0;
+    stack[stack_size++] = {0, distance_squared(_nodes[0], point)};
+
+    while (stack_size > 0)
+    {
+        auto const entry = stack[--stack_size];
+        if (entry.distance_squared > max_distance_squared)
+            continue;
+        auto const& node = _nodes[entry.node];
+        if (node.triangles_count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.triangles_count; ++i)
+            {
+                auto const& triangle  = _triangles[i];
+                auto const  candidate = closest_point_on_triangle(point, triangle.vertices[0], triangle.vertices[1], triangle.vertices[2]);
+                float const d2        = glm::dot(candidate - point, candidate - point);
+                if (d2 <= max_distance_squared)
+                {
+                    max_distance_squared = d2;
+                    res                  = ClosestPoint{.position = candidate, .distance = 0.f, .triangle_index = triangle.index};
+                }
+            }
+            continue;
+        }
+
+        auto near = StackEntry{node.first, distance_squared(_nodes[node.first], point)};
+        auto far  = StackEntry{node.first + 1, distance_squared(_nodes[node.first + 1], point)};
+        if (far.distance_squared < near.distance_squared)
+            std::swap(near, far);
+        assert(stack_size + 2 <= stack.size());
+        stack[stack_size++] = far;
+        stack[stack_size++] = near;
+    }
+    if (res)
+        res->distance = std::sqrt(max_distance_squared);
+    return res;
+}
+
+} // namespace gl
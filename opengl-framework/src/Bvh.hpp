@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+#include "bounds.hpp"
+#include "glm/glm.hpp"
+#include "load_mesh.hpp"
+
+namespace gl {
+
+struct Ray {
+    glm::vec3 origin{0.f};
+    glm::vec3 direction{0.f, 0.f, -1.f}; /// Doesn't need to be normalized, but the distances are then expressed in multiples of its length
+};
+
+struct RayHit {
+    float     distance{};       /// Along the ray
+    uint32_t  triangle_index{}; /// Index of the triangle in the index buffer that was used to build the BVH (i.e. its first index is at 3 * triangle_index)
+    glm::vec2 barycentrics{};   /// Weights of the 2nd and 3rd vertices of the triangle
+};
+
+struct ClosestPoint {
+    glm::vec3 position{};
+    float     distance{};
+    uint32_t  triangle_index{};
+};
+
+struct Bvh_Options {
+    size_t max_triangles_per_leaf{4};
+    size_t bins_count{16};             /// Number of candidate split planes per axis evaluated by the Surface Area Heuristic
+    size_t parallel_threshold{16384}; /// Below this number of triangles, the BVH is built on the calling thread
+};
+
+/// Bounding Volume Hierarchy over the triangles of a mesh, to find which triangles a ray hits, or which one is the closest to a point, without testing all of them.
+/// Built top-down with binned SAH (Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies", 2007). The subtrees are built in parallel with gl::parallel_for().
+/// The triangles are copied into the BVH, so the mesh data can be discarded afterwards.
+class Bvh {
+public:
+    Bvh(std::span<glm::vec3 const> positions, std::span<uint32_t const> indices, Bvh_Options const& = {});
+    /// Uses the Position3D at location 0.
+    explicit Bvh(MeshData const&, Bvh_Options const& = {});
+
+    /// Closest hit whose distance is in [0, max_distance]
+    auto intersect(Ray const&, float max_distance = std::numeric_limits<float>::infinity()) const -> std::optional<RayHit>;
+    /// Closest point of the mesh that is at most max_distance away from `point`
+    auto closest_point(glm::vec3 const& point, float max_distance = std::numeric_limits<float>::infinity()) const -> std::optional<ClosestPoint>;
+
+    auto bounds() const -> BoundingBox;
+    auto triangles_count() const -> size_t { return _triangles.size(); }
+    auto nodes_count() const -> size_t { return _nodes.size(); }
+
+    /// 32 bytes, so that two siblings fill a cache line
+    struct Node {
+        glm::vec3 min{};
+        uint32_t  first{}; /// Index of the first child if this is an inner node (the second one is right after it), or of the first triangle if it is a leaf
+        glm::vec3 max{};
+        uint32_t  triangles_count{}; /// 0 for inner nodes
+    };
+    struct Triangle {
+        std::array<glm::vec3, 3> vertices{};
+        uint32_t                 index{}; /// In the original index buffer
+    };
+
+private:
+    std::vector<Node>     _nodes{}; /// _nodes[0] is the root. The children of a node are always stored after it.
+    std::vector<Triangle> _triangles{};
+};
+
+} // namespace gl
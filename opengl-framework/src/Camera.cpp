@@ -1,9 +1,12 @@
 #include "Camera.hpp"
+#include <cmath>
 #include "EventsCallbacks.hpp"
 #include "glfw.hpp"
 #include "glm/common.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/gtc/matrix_access.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
 
 namespace gl {
 
@@ -17,6 +20,113 @@ Camera::Camera(glm::vec3 const& position, glm::vec3 const& look_at)
 {
 }
 
+auto frustum_from_view_projection(glm::mat4 const& view_projection_matrix) -> Frustum
+{
+    auto const row = [&](int i) { return glm::row(view_projection_matrix, i); };
+    auto       res = Frustum{};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        res.planes[static_cast<size_t>(2 * axis)]     = row(3) + row(axis);
+        res.planes[static_cast<size_t>(2 * axis + 1)] = row(3) - row(axis);
+    }
+    for (auto& plane : res.planes)
+    {
+        float const length = glm::length(glm::vec3{plane});
+        plane              = length > 1e-6f
+                                 ? plane / length
+                                 : glm::vec4{0.f, 0.f, 0.f, 1.f}; // Plane at infinity
+    }
+    return res;
+}
+
+void Camera::update_view() const
+{
+    if (_cache.view_is_valid)
+        return;
+    _cache.view                     = glm::affineInverse(_transform_matrix); // Cheaper than a general inverse, because the transform is only made of rotations and translations
+    _cache.view_is_valid            = true;
+    _cache.view_projection_is_valid = false;
+}
+
+void Camera::update_projection(float aspect_ratio) const
+{
+    if (_cache.projection_is_valid && _cache.aspect_ratio == aspect_ratio)
+        return;
+    _cache.projection               = std::isinf(_projection.far_plane)
+                                          ? glm::infinitePerspective(_projection.field_of_view, aspect_ratio, _projection.near_plane)
+                                          : glm::perspective(_projection.field_of_view, aspect_ratio, _projection.near_plane, _projection.far_plane);
+    _cache.inverse_projection       = glm::inverse(_cache.projection);
+    _cache.aspect_ratio             = aspect_ratio;
+    _cache.projection_is_valid      = true;
+    _cache.view_projection_is_valid = false;
+}
+
+void Camera::update_view_projection(float aspect_ratio) const
+{
+    update_view();
+    update_projection(aspect_ratio);
+    if (_cache.view_projection_is_valid)
+        return;
+    _cache.view_projection          = _cache.projection * _cache.view;
+    _cache.inverse_view_projection  = _transform_matrix * _cache.inverse_projection;
+    _cache.frustum                  = frustum_from_view_projection(_cache.view_projection);
+    _cache.view_projection_is_valid = true;
+}
+
+auto Camera::view_matrix() const -> glm::mat4 const&
+{
+    update_view();
+    return _cache.view;
+}
+
+auto Camera::projection_matrix(float aspect_ratio) const -> glm::mat4 const&
+{
+    update_projection(aspect_ratio);
+    return _cache.projection;
+}
+
+auto Camera::inverse_projection_matrix(float aspect_ratio) const -> glm::mat4 const&
+{
+    update_projection(aspect_ratio);
+    return _cache.inverse_projection;
+}
+
+auto Camera::view_projection_matrix(float aspect_ratio) const -> glm::mat4 const&
+{
+    update_view_projection(aspect_ratio);
+    return _cache.view_projection;
+}
+
+auto Camera::inverse_view_projection_matrix(float aspect_ratio) const -> glm::mat4 const&
+{
+    update_view_projection(aspect_ratio);
+    return _cache.inverse_view_projection;
+}
+
+auto Camera::frustum(float aspect_ratio) const -> Frustum const&
+{
+    update_view_projection(aspect_ratio);
+    return _cache.frustum;
+}
+
+void Camera::set_projection(Projection_Perspective const& projection)
+{
+    _projection                = projection;
+    _cache.projection_is_valid = false;
+}
+
+void Camera::set_transform_matrix(glm::mat4 const& transform_matrix)
+{
+    _transform_matrix = transform_matrix;
+    invalidate_view();
+}
+
+void Camera::set_view_matrix(glm::mat4 const& view_matrix)
+{
+    _transform_matrix = glm::inverse(view_matrix);
+    invalidate_view();
+}
+
 auto Camera::right_axis() const -> glm::vec3
 {
     return glm::normalize(glm::column(_transform_matrix, 0));
@@ -37,6 +147,7 @@ auto Camera::position() const -> glm::vec3
 void Camera::translate(glm::vec3 const& delta_position, bool also_translate_looked_at_point)
 {
     _transform_matrix = glm::translate(glm::mat4{1.f}, delta_position) * _transform_matrix;
+    invalidate_view();
     if (also_translate_looked_at_point)
         _looked_at += delta_position;
 }
@@ -51,6 +162,7 @@ void Camera::rotate_around(glm::vec3 const& center, float angle, glm::vec3 const
 void Camera::rotate(float angle, glm::vec3 const& axis)
 {
     _transform_matrix = glm::rotate(glm::mat4{1.f}, angle, axis) * _transform_matrix;
+    invalidate_view();
 }
 
 auto Camera::events_callbacks() -> EventsCallbacks
@@ -1,10 +1,27 @@
 #pragma once
-// #include "Projection_Perspective.h"
+#include <array>
+#include <limits>
 #include "EventsCallbacks.hpp"
 #include "glm/glm.hpp"
 
 namespace gl {
 
+struct Projection_Perspective {
+    float field_of_view{1.f}; /// Vertical, in radians
+    float near_plane{0.001f};
+    float far_plane{std::numeric_limits<float>::infinity()}; /// Can be infinite
+};
+
+/// The 6 planes that bound the volume seen by a camera, in world space.
+/// Each plane is stored as (normal, d), with a normalized normal pointing inside the frustum: a point p is inside when dot(normal, p) + d >= 0 for all the planes.
+struct Frustum {
+    std::array<glm::vec4, 6> planes{}; /// Left, right, bottom, top, near, far
+};
+
+/// Extracts the planes from a view-projection matrix (Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix", 2001).
+/// An infinite far plane becomes a plane that contains everything.
+auto frustum_from_view_projection(glm::mat4 const& view_projection_matrix) -> Frustum;
+
 namespace internal {
 enum class CameraControllerState {
     Idle,
@@ -17,24 +34,25 @@ class Camera {
 public:
     explicit Camera(glm::vec3 const& position = glm::vec3{5.f, 1.f, 2.f} * 0.2f, glm::vec3 const& look_at = glm::vec3{0.f});
 
-    auto transform_matrix() const -> glm::mat4 { return _transform_matrix; }
-    auto view_matrix() const -> glm::mat4 { return glm::inverse(_transform_matrix); }
-    // auto      projection_matrix(float aspect_ratio) const -> glm::mat4 { return Cool::projection_matrix(_projection, aspect_ratio); }
-    // auto      inverse_projection_matrix(float aspect_ratio) const -> glm::mat4 { return glm::inverse(projection_matrix(aspect_ratio)); }
-    // auto      inverse_view_projection_matrix(float aspect_ratio) const -> glm::mat4;
-    // auto      view_projection_matrix(float aspect_ratio) const -> glm::mat4;
+    /// All the matrices are cached, and only recomputed when the camera (or the aspect ratio) changes. So you can call these functions as often as you want.
+    auto transform_matrix() const -> glm::mat4 const& { return _transform_matrix; }
+    auto view_matrix() const -> glm::mat4 const&;
+    auto projection_matrix(float aspect_ratio) const -> glm::mat4 const&;
+    auto inverse_projection_matrix(float aspect_ratio) const -> glm::mat4 const&;
+    auto view_projection_matrix(float aspect_ratio) const -> glm::mat4 const&;
+    auto inverse_view_projection_matrix(float aspect_ratio) const -> glm::mat4 const&;
+    auto frustum(float aspect_ratio) const -> Frustum const&;
     auto right_axis() const -> glm::vec3;
     auto up_axis() const -> glm::vec3;
     auto front_axis() const -> glm::vec3;
     auto position() const -> glm::vec3;
-    // float     far_plane() const { return _projection.far_plane; }
-    // float&    far_plane() { return _projection.far_plane; }
+    auto far_plane() const -> float { return _projection.far_plane; }
 
-    // auto projection() -> Projection_Perspective& { return _projection; }
-    // auto projection() const -> const Projection_Perspective& { return _projection; }
+    auto projection() const -> Projection_Perspective const& { return _projection; }
+    void set_projection(Projection_Perspective const&);
 
-    void set_transform_matrix(glm::mat4 const& transform_matrix) { _transform_matrix = transform_matrix; }
-    void set_view_matrix(glm::mat4 const& view_matrix) { _transform_matrix = glm::inverse(view_matrix); }
+    void set_transform_matrix(glm::mat4 const& transform_matrix);
+    void set_view_matrix(glm::mat4 const& view_matrix);
 
     /// Translation expressed in world space
     void translate(glm::vec3 const& delta_position, bool also_translate_looked_at_point = true);
@@ -45,13 +63,33 @@ public:
     auto events_callbacks() -> EventsCallbacks;
 
 private:
-    glm::mat4 _transform_matrix{1.f};
-    glm::vec3 _looked_at{};
+    void invalidate_view() { _cache.view_is_valid = false; }
+    void update_view() const;
+    void update_projection(float aspect_ratio) const;
+    void update_view_projection(float aspect_ratio) const;
+
+private:
+    glm::mat4              _transform_matrix{1.f};
+    glm::vec3              _looked_at{};
+    Projection_Perspective _projection{};
+
+    struct Cache {
+        glm::mat4 view{1.f};
+        glm::mat4 projection{1.f};
+        glm::mat4 inverse_projection{1.f};
+        glm::mat4 view_projection{1.f};
+        glm::mat4 inverse_view_projection{1.f};
+        Frustum   frustum{};
+        float     aspect_ratio{};
+        bool      view_is_valid{false};
+        bool      projection_is_valid{false};
+        bool      view_projection_is_valid{false};
+    };
+    mutable Cache _cache{};
 
     internal::CameraControllerState _state{internal::CameraControllerState::Idle};
     int                             _current_button{};
     glm::vec2                       _previous_mouse_pos{};
-    // Projection_Perspective _projection{};
 };
 
 } // namespace gl
\ No newline at end of file
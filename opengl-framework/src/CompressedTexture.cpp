@@ -0,0 +1,530 @@
+#include "CompressedTexture.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include "glm/glm.hpp"
+#include "handle_error.hpp"
+#include "parallel_for.hpp"
+
+namespace gl {
+
+namespace {
+
+using Block = std::array<glm::u8vec4, 16>; // The 4x4 pixels that get compressed together
+
+auto block_size_in_bytes(CompressionFormat format) -> size_t
+{
+    return format == CompressionFormat::BC4 ? 8 : 16;
+}
+
+auto blocks_count(GLsizei size) -> size_t
+{
+    return static_cast<size_t>((size + 3) / 4);
+}
+
+auto level_size(GLsizei size, size_t level) -> GLsizei
+{
+    return std::max(size >> level, 1);
+}
+
+/// Reads a 4x4 block of pixels. On the right and top borders, the last row / column is repeated when the image size is not a multiple of 4.
+auto fetch_block(std::span<uint8_t const> rgba_pixels, GLsizei width, GLsizei height, size_t block_x, size_t block_y) -> Block
+{
+    auto block = Block{};
+    for (size_t y = 0; y < 4; ++y)
+    {
+        for (size_t x = 0; x < 4; ++x)
+        {
+            auto const px  = std::min(block_x * 4 + x, static_cast<size_t>(width - 1));
+            auto const py  = std::min(block_y * 4 + y, static_cast<size_t>(height - 1));
+            auto const idx = (px + py * static_cast<size_t>(width)) * 4;
+            block[x + 4 * y] = glm::u8vec4{rgba_pixels[idx], rgba_pixels[idx + 1], rgba_pixels[idx + 2], rgba_pixels[idx + 3]};
+        }
+    }
+    return block;
+}
+
+/// Halves the size of the image, averaging each group of 2x2 pixels.
+auto downsample(std::span<uint8_t const> rgba_pixels, GLsizei width, GLsizei height) -> std::vector<uint8_t>
+{
+    auto const new_width  = static_cast<size_t>(std::max(width / 2, 1));
+    auto const new_height = static_cast<size_t>(std::max(height / 2, 1));
+    auto       res        = std::vector<uint8_t>(new_width * new_height * 4);
+    auto const pixel      = [&](size_t x, size_t y, size_t channel) {
+        x = std::min(x, static_cast<size_t>(width - 1));
+        y = std::min(y, static_cast<size_t>(height - 1));
+        return static_cast<unsigned int>(rgba_pixels[(x + y * static_cast<size_t>(width)) * 4 + channel]);
+    };
+    for (size_t y = 0; y < new_height; ++y)
+    {
+        for (size_t x = 0; x < new_width; ++x)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                auto const sum = pixel(2 * x, 2 * y, c) + pixel(2 * x + 1, 2 * y, c) + pixel(2 * x, 2 * y + 1, c) + pixel(2 * x + 1, 2 * y + 1, c);
+                res[(x + y * new_width) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return res;
+}
+
+/// Writes the bits of a 128-bit block, starting with the least significant bit.
+class BitWriter {
+public:
+    void write(uint32_t value, unsigned int bits_count)
+    {
+        for (unsigned int i = 0; i < bits_count; ++i, ++_position)
+        {
+            if ((value >> i) & 1u)
+                _words[_position / 64] |= uint64_t{1} << (_position % 64);
+        }
+    }
+
+    void copy_to(std::byte* dst) const { std::memcpy(dst, _words.data(), sizeof(_words)); }
+
+private:
+    std::array<uint64_t, 2> _words{};
+    unsigned int            _position{0};
+};
+
+// ---BC4 / BC5---
+
+/// Encodes 16 values of a single channel, using the 8-values mode of BC4 (the two endpoints are the min and the max of the block).
+void encode_bc4(std::array<uint8_t, 16> const& values, std::byte* dst)
+{
+    auto const [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+    auto const min              = *min_it;
+    auto const max              = *max_it;
+
+    uint64_t bits = uint64_t{max} | (uint64_t{min} << 8);
+    if (max != min)
+    {
+        for (size_t i = 0; i < 16; ++i)
+        {
+            // Position between the two endpoints, 0 being max and 7 being min
+            auto const position = static_cast<uint64_t>(std::lround(static_cast<float>(max - values[i]) * 7.f / static_cast<float>(max - min)));
+            // In the palette, index 0 is max, index 1 is min, and indices 2 to 7 are the interpolated values from max to min
+            auto const index    = position == 0 ? 0 : position == 7 ? 1 : position + 1;
+            bits |= index << (16 + 3 * i);
+        }
+    }
+    std::memcpy(dst, &bits, 8);
+}
+
+auto channel(Block const& block, glm::length_t c) -> std::array<uint8_t, 16>
+{
+    auto res = std::array<uint8_t, 16>{};
+    for (size_t i = 0; i < 16; ++i)
+        res[i] = block[i][c];
+    return res;
+}
+
+// ---BC7---
+// We only use mode 6: a single RGBA line per block with 7-bit endpoints + 1 p-bit, and 4-bit indices.
+// It is the most versatile mode, and gives good results on most color textures.
+
+constexpr auto bc7_weights = std::array<int, 16>{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct QuantizedEndpoint {
+    glm::ivec4 color7{}; // 7 bits per channel
+    int        p_bit{};
+
+    auto value() const -> glm::ivec4 { return color7 * 2 + p_bit; }
+};
+
+auto quantize(glm::vec4 const& endpoint) -> QuantizedEndpoint
+{
+    auto best       = QuantizedEndpoint{};
+    auto best_error = std::numeric_limits<float>::max();
+    for (int p_bit = 0; p_bit < 2; ++p_bit)
+    {
+        auto const candidate = QuantizedEndpoint{
+            .color7 = glm::clamp(glm::ivec4{glm::round((endpoint - static_cast<float>(p_bit)) / 2.f)}, 0, 127),
+            .p_bit  = p_bit,
+        };
+        auto const delta = glm::vec4{candidate.value()} - endpoint;
+        auto const error = glm::dot(delta, delta);
+        if (error < best_error)
+        {
+            best_error = error;
+            best       = candidate;
+        }
+    }
+    return best;
+}
+
+auto interpolate(glm::ivec4 const& e0, glm::ivec4 const& e1, int weight) -> glm::ivec4
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+struct Bc7Candidate {
+    QuantizedEndpoint      e0{};
+    QuantizedEndpoint      e1{};
+    std::array<int, 16>    indices{};
+    int                    error{};
+};
+
+auto make_candidate(Block const& block, glm::vec4 const& endpoint0, glm::vec4 const& endpoint1) -> Bc7Candidate
+{
+    auto res = Bc7Candidate{.e0 = quantize(endpoint0), .e1 = quantize(endpoint1)};
+
+    auto palette = std::array<glm::ivec4, 16>{};
+    for (size_t i = 0; i < 16; ++i)
+        palette[i] = interpolate(res.e0.value(), res.e1.value(), bc7_weights[i]);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        auto best_error = std::numeric_limits<int>::max();
+        for (size_t j = 0; j < 16; ++j)
+        {
+            auto const delta = palette[j] - glm::ivec4{block[i]};
+            auto const error = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z + delta.w * delta.w;
+            if (error < best_error)
+            {
+                best_error     = error;
+                res.indices[i] = static_cast<int>(j);
+            }
+        }
+        res.error += best_error;
+    }
+    return res;
+}
+
+/// Returns the direction along which the colors of the block vary the most.
+auto principal_axis(Block const& block, glm::vec4 const& mean) -> glm::vec4
+{
+    auto covariance = glm::mat4{0.f};
+    for (auto const& pixel : block)
+    {
+        auto const d = glm::vec4{pixel} - mean;
+        covariance += glm::outerProduct(d, d);
+    }
+    auto axis = glm::vec4{1.f};
+    for (int i = 0; i < 8; ++i) // Power iteration
+    {
+        axis             = covariance * axis;
+        auto const norm2 = glm::dot(axis, axis);
+        if (norm2 < 1e-12f)
+            return glm::vec4{0.f};
+        axis /= std::sqrt(norm2);
+    }
+    return axis;
+}
+
+void encode_bc7(Block const& block, std::byte* dst)
+{
+    auto mean = glm::vec4{0.f};
+    auto min  = glm::vec4{255.f};
+    auto max  = glm::vec4{0.f};
+    for (auto const& pixel : block)
+    {
+        mean += glm::vec4{pixel};
+        min = glm::min(min, glm::vec4{pixel});
+        max = glm::max(max, glm::vec4{pixel});
+    }
+    mean /= 16.f;
+
+    // Candidate 1: the extent of the block along its principal axis
+    auto const axis  = principal_axis(block, mean);
+    float      t_min = 0.f;
+    float      t_max = 0.f;
+    for (auto const& pixel : block)
+    {
+        auto const t = glm::dot(glm::vec4{pixel} - mean, axis);
+        t_min        = std::min(t_min, t);
+        t_max        = std::max(t_max, t);
+    }
+    auto best = make_candidate(block, glm::clamp(mean + axis * t_min, 0.f, 255.f), glm::clamp(mean + axis * t_max, 0.f, 255.f));
+
+    // Candidate 2: the diagonal of the bounding box, which is sometimes better for blocks with few distinct colors
+    if (best.error > 0)
+    {
+        auto const candidate = make_candidate(block, min, max);
+        if (candidate.error < best.error)
+            best = candidate;
+    }
+
+    // The most significant bit of the first index is implicitly 0, so we might need to swap the endpoints
+    if (best.indices[0] >= 8)
+    {
+        std::swap(best.e0, best.e1);
+        for (auto& index : best.indices)
+            index = 15 - index;
+    }
+
+    auto bits = BitWriter{};
+    bits.write(1u << 6, 7); // Mode 6
+    for (glm::length_t c = 0; c < 4; ++c)
+    {
+        bits.write(static_cast<uint32_t>(best.e0.color7[c]), 7);
+        bits.write(static_cast<uint32_t>(best.e1.color7[c]), 7);
+    }
+    bits.write(static_cast<uint32_t>(best.e0.p_bit), 1);
+    bits.write(static_cast<uint32_t>(best.e1.p_bit), 1);
+    bits.write(static_cast<uint32_t>(best.indices[0]), 3);
+    for (size_t i = 1; i < 16; ++i)
+        bits.write(static_cast<uint32_t>(best.indices[i]), 4);
+    bits.copy_to(dst);
+}
+
+auto compress_level(std::span<uint8_t const> rgba_pixels, GLsizei width, GLsizei height, CompressionFormat format) -> std::vector<std::byte>
+{
+    auto const blocks_x   = blocks_count(width);
+    auto const blocks_y   = blocks_count(height);
+    auto const block_size = block_size_in_bytes(format);
+    auto       res        = std::vector<std::byte>(blocks_x * blocks_y * block_size);
+
+    parallel_for(blocks_y, 1, [&](size_t begin, size_t end) {
+        for (size_t by = begin; by < end; ++by)
+        {
+            for (size_t bx = 0; bx < blocks_x; ++bx)
+            {
+                auto const block = fetch_block(rgba_pixels, width, height, bx, by);
+                auto*      dst   = &res[(bx + by * blocks_x) * block_size];
+                switch (format)
+                {
+                case CompressionFormat::BC4:
+                    encode_bc4(channel(block, 0), dst);
+                    break;
+                case CompressionFormat::BC5:
+                    encode_bc4(channel(block, 0), dst);
+                    encode_bc4(channel(block, 1), dst + 8);
+                    break;
+                case CompressionFormat::BC7:
+                case CompressionFormat::BC7_SRGB:
+                    encode_bc7(block, dst);
+                    break;
+                }
+            }
+        }
+    });
+    return res;
+}
+
+// ---KTX2---
+
+constexpr auto ktx2_identifier = std::array<uint8_t, 12>{0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+struct Ktx2Header {
+    uint32_t vk_format{};
+    uint32_t type_size{};
+    uint32_t pixel_width{};
+    uint32_t pixel_height{};
+    uint32_t pixel_depth{};
+    uint32_t layer_count{};
+    uint32_t face_count{};
+    uint32_t level_count{};
+    uint32_t supercompression_scheme{};
+    uint32_t dfd_byte_offset{};
+    uint32_t dfd_byte_length{};
+    uint32_t kvd_byte_offset{};
+    uint32_t kvd_byte_length{};
+    uint32_t sgd_byte_offset[2]{}; // NOLINT(*avoid-c-arrays) uint64_t, split to avoid padding in the struct
+    uint32_t sgd_byte_length[2]{}; // NOLINT(*avoid-c-arrays)
+};
+static_assert(sizeof(Ktx2Header) == 68);
+
+struct Ktx2LevelIndex {
+    uint64_t byte_offset{};
+    uint64_t byte_length{};
+    uint64_t uncompressed_byte_length{};
+};
+
+auto vk_format(CompressionFormat format) -> uint32_t
+{
+    switch (format)
+    {
+    case CompressionFormat::BC4: return 139;      // VK_FORMAT_BC4_UNORM_BLOCK
+    case CompressionFormat::BC5: return 141;      // VK_FORMAT_BC5_UNORM_BLOCK
+    case CompressionFormat::BC7: return 145;      // VK_FORMAT_BC7_UNORM_BLOCK
+    case CompressionFormat::BC7_SRGB: return 146; // VK_FORMAT_BC7_SRGB_BLOCK
+    }
+    return 0;
+}
+
+auto compression_format(uint32_t vk_format, std::filesystem::path const& path) -> CompressionFormat
+{
+    switch (vk_format)
+    {
+    case 139: return CompressionFormat::BC4;
+    case 141: return CompressionFormat::BC5;
+    case 145: return CompressionFormat::BC7;
+    case 146: return CompressionFormat::BC7_SRGB;
+    default:
+        handle_error(std::format("\"{}\" uses an unsupported format (vkFormat = {}). Only BC4, BC5 and BC7 are supported.", path.string(), vk_format));
+        return {};
+    }
+}
+
+/// Basic Data Format Descriptor, as described in https://registry.khronos.org/DataFormat/specs/1.3/dataformat.1.3.html
+auto data_format_descriptor(CompressionFormat format) -> std::vector<uint32_t>
+{
+    uint32_t const samples_count = format == CompressionFormat::BC5 ? 2 : 1;
+    uint32_t const block_size    = 24 + 16 * samples_count;
+    uint32_t const color_model   = format == CompressionFormat::BC4   ? 131 // KHR_DF_MODEL_BC4
+                                   : format == CompressionFormat::BC5 ? 132 // KHR_DF_MODEL_BC5
+                                                                      : 134; // KHR_DF_MODEL_BC7
+    uint32_t const transfer      = format == CompressionFormat::BC7_SRGB ? 2 : 1; // KHR_DF_TRANSFER_SRGB / KHR_DF_TRANSFER_LINEAR
+    uint32_t const primaries     = 1;                                             // KHR_DF_PRIMARIES_BT709
+    uint32_t const sample_bits   = format == CompressionFormat::BC7 || format == CompressionFormat::BC7_SRGB ? 128 : 64;
+
+    auto res = std::vector<uint32_t>{
+        4 + block_size,                                  // dfdTotalSize
+        0,                                               // vendorId = KHR, descriptorType = basic
+        2 | (block_size << 16),                          // versionNumber = 1.3, descriptorBlockSize
+        color_model | (primaries << 8) | (transfer << 16), // colorModel, colorPrimaries, transferFunction, flags
+        3 | (3 << 8),                                    // texelBlockDimension: 4x4x1x1 (stored minus one)
+        static_cast<uint32_t>(block_size_in_bytes(format)), // bytesPlane0
+        0,                                               // bytesPlane4-7
+    };
+    for (uint32_t i = 0; i < samples_count; ++i)
+    {
+        res.push_back((i * 64) | ((sample_bits - 1) << 16) | (i << 24)); // bitOffset, bitLength (minus one), channelType (red, then green)
+        res.push_back(0);                                                // samplePosition
+        res.push_back(0);                                                // sampleLower
+        res.push_back(0xFFFFFFFF);                                       // sampleUpper
+    }
+    return res;
+}
+
+auto align(uint64_t offset, uint64_t alignment) -> uint64_t
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+auto gl_internal_format(CompressionFormat format) -> GLenum
+{
+    switch (format)
+    {
+    case CompressionFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case CompressionFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+    case CompressionFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    case CompressionFormat::BC7_SRGB: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+auto compress_image(std::span<uint8_t const> rgba_pixels, GLsizei width, GLsizei height, Compression_Options const& options) -> CompressedImage
+{
+    assert(rgba_pixels.size() == static_cast<size_t>(width) * static_cast<size_t>(height) * 4 && "The pixels must be in RGBA8 format (4 bytes per pixel).");
+
+    auto res = CompressedImage{.format = options.format, .width = width, .height = height};
+
+    auto mip        = std::vector<uint8_t>{};
+    auto mip_pixels = rgba_pixels;
+    auto mip_width  = width;
+    auto mip_height = height;
+    while (true)
+    {
+        res.levels.push_back(compress_level(mip_pixels, mip_width, mip_height, options.format));
+        if (!options.generate_mipmaps || (mip_width == 1 && mip_height == 1))
+            break;
+        mip        = downsample(mip_pixels, mip_width, mip_height);
+        mip_pixels = mip;
+        mip_width  = std::max(mip_width / 2, 1);
+        mip_height = std::max(mip_height / 2, 1);
+    }
+    return res;
+}
+
+void save_ktx2(std::filesystem::path const& path, CompressedImage const& image)
+{
+    auto const dfd         = data_format_descriptor(image.format);
+    auto const level_count = image.levels.size();
+    auto const alignment   = block_size_in_bytes(image.format); // lcm(block size, 4)
+
+    auto header = Ktx2Header{
+        .vk_format       = vk_format(image.format),
+        .type_size       = 1,
+        .pixel_width     = static_cast<uint32_t>(image.width),
+        .pixel_height    = static_cast<uint32_t>(image.height),
+        .face_count      = 1,
+        .level_count     = static_cast<uint32_t>(level_count),
+        .dfd_byte_offset = static_cast<uint32_t>(ktx2_identifier.size() + sizeof(Ktx2Header) + level_count * sizeof(Ktx2LevelIndex)),
+        .dfd_byte_length = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t)),
+    };
+
+    // The spec requires the smallest mips to be stored first
+    auto     level_index = std::vector<Ktx2LevelIndex>(level_count);
+    uint64_t offset      = header.dfd_byte_offset + header.dfd_byte_length;
+    for (size_t i = level_count; i-- > 0;)
+    {
+        offset         = align(offset, alignment);
+        level_index[i] = {.byte_offset = offset, .byte_length = image.levels[i].size(), .uncompressed_byte_length = image.levels[i].size()};
+        offset += image.levels[i].size();
+    }
+
+    auto file = std::ofstream{path, std::ios::binary};
+    if (!file)
+        handle_error(std::format("Failed to open \"{}\" for writing.", path.string()));
+    auto const write = [&](void const* data, size_t size) {
+        file.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+    };
+    write(ktx2_identifier.data(), ktx2_identifier.size());
+    write(&header, sizeof(header));
+    write(level_index.data(), level_index.size() * sizeof(Ktx2LevelIndex));
+    write(dfd.data(), dfd.size() * sizeof(uint32_t));
+    for (size_t i = level_count; i-- > 0;)
+    {
+        auto const padding = std::array<char, 16>{};
+        write(padding.data(), level_index[i].byte_offset - static_cast<uint64_t>(file.tellp()));
+        write(image.levels[i].data(), image.levels[i].size());
+    }
+    if (!file)
+        handle_error(std::format("Failed to write \"{}\".", path.string()));
+}
+
+auto load_ktx2(std::filesystem::path const& path) -> CompressedImage
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file)
+        handle_error(std::format("Failed to open \"{}\".", path.string()));
+    auto const bytes = std::vector<char>{std::istreambuf_iterator<char>{file}, {}};
+
+    auto const read = [&](void* dst, size_t offset, size_t size) {
+        if (offset + size > bytes.size())
+            handle_error(std::format("\"{}\" is not a valid .ktx2 file: it is truncated.", path.string()));
+        std::memcpy(dst, bytes.data() + offset, size);
+    };
+
+    auto identifier = std::array<uint8_t, 12>{};
+    read(identifier.data(), 0, identifier.size());
+    if (identifier != ktx2_identifier)
+        handle_error(std::format("\"{}\" is not a .ktx2 file.", path.string()));
+
+    auto header = Ktx2Header{};
+    read(&header, identifier.size(), sizeof(header));
+    if (header.supercompression_scheme != 0)
+        handle_error(std::format("\"{}\" uses supercompression, which is not supported.", path.string()));
+    if (header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1)
+        handle_error(std::format("\"{}\" is not a simple 2D texture. Arrays, cubemaps and 3D textures are not supported.", path.string()));
+
+    auto res = CompressedImage{
+        .format = compression_format(header.vk_format, path),
+        .width  = static_cast<GLsizei>(header.pixel_width),
+        .height = static_cast<GLsizei>(header.pixel_height),
+    };
+    auto const level_count = std::max(header.level_count, 1u); // 0 means that the mips should be generated at runtime, but the file still contains level 0
+    for (size_t i = 0; i < level_count; ++i)
+    {
+        auto level = Ktx2LevelIndex{};
+        read(&level, ktx2_identifier.size() + sizeof(Ktx2Header) + i * sizeof(Ktx2LevelIndex), sizeof(level));
+        auto const expected_size = blocks_count(level_size(res.width, i)) * blocks_count(level_size(res.height, i)) * block_size_in_bytes(res.format);
+        if (level.byte_length != expected_size)
+            handle_error(std::format("\"{}\" is not a valid .ktx2 file: mip level {} has the wrong size.", path.string(), i));
+        auto& data = res.levels.emplace_back(level.byte_length);
+        read(data.data(), level.byte_offset, level.byte_length);
+    }
+    return res;
+}
+
+} // namespace gl
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "glad/gl.h"
+
+namespace gl {
+
+/// Block-compressed formats that we know how to encode, save to a .ktx2 file, and upload to the GPU
+/// See https://www.khronos.org/opengl/wiki/Red_Green_Texture_Compression and https://www.khronos.org/opengl/wiki/BPTC_Texture_Compression for more details
+enum class CompressionFormat {
+    BC4,       /// Single channel (red), 8 bytes per 4x4 block. Great for masks and height maps.
+    BC5,       /// Two channels (red and green), 16 bytes per 4x4 block. Great for normal maps.
+    BC7,       /// RGBA, 16 bytes per 4x4 block. Great for color textures.
+    BC7_SRGB,  /// Same as BC7, but the colors are decoded from sRGB to linear by the GPU when sampling.
+};
+
+/// The 4x4 blocks of all the mipmap levels of an image
+struct CompressedImage {
+    CompressionFormat                   format{};
+    GLsizei                             width{};
+    GLsizei                             height{};
+    std::vector<std::vector<std::byte>> levels{}; /// levels[0] is the full-resolution image, each following level is half the size of the previous one
+};
+
+struct Compression_Options {
+    CompressionFormat format{CompressionFormat::BC7};
+    bool              generate_mipmaps{true};
+};
+
+/// Compresses an RGBA8 image (4 bytes per pixel). Uses all the threads of gl::parallel_for().
+auto compress_image(std::span<uint8_t const> rgba_pixels, GLsizei width, GLsizei height, Compression_Options const& = {}) -> CompressedImage;
+
+/// Saves the image as a .ktx2 file (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html), without any supercompression.
+void save_ktx2(std::filesystem::path const& path, CompressedImage const&);
+/// Loads a .ktx2 file that has been written by save_ktx2() (or by any other tool, as long as it uses one of our CompressionFormat and no supercompression).
+auto load_ktx2(std::filesystem::path const& path) -> CompressedImage;
+
+/// The format to pass to glCompressedTexImage2D()
+auto gl_internal_format(CompressionFormat) -> GLenum;
+
+} // namespace gl
@@ -0,0 +1,98 @@
+#include "DrawBatch.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <numeric>
+
+namespace gl {
+
+/// Orphans the previous storage, so that we never wait for the GPU to finish reading it
+static void upload(GLenum target, GLuint buffer, size_t& capacity, std::span<std::byte const> data)
+{
+    capacity = std::max(capacity, std::bit_ceil(data.size()));
+    glBindBuffer(target, buffer);
+    glBufferData(target, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(target, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+}
+
+DrawBatch::DrawBatch(DrawBatch_Options const& options)
+    : _draw_id_location{options.draw_id_location}
+{}
+
+auto DrawBatch::add(SharedMesh const& mesh, GLuint instances_count) -> GLuint
+{
+    assert(std::none_of(mesh.pool().members().begin(), mesh.pool().members().end(), [&](VertexMember const& member) { return member.location == _draw_id_location; })
+           && "The layout of the mesh uses the same location as the draw id. Change DrawBatch_Options::draw_id_location.");
+
+    auto group = std::find_if(_groups.begin(), _groups.end(), [&](Group const& group) {
+        return group.pool == &mesh.pool() && group.arena_index == mesh.arena_index();
+    });
+    if (group == _groups.end())
+        group = _groups.insert(_groups.end(), Group{.pool = &mesh.pool(), .arena_index = mesh.arena_index()});
+
+    auto const draw_id = _instances_count;
+    group->commands.push_back({
+        .count          = static_cast<GLuint>(mesh.indices_count()),
+        .instance_count = instances_count,
+        .first_index    = mesh.first_index(),
+        .base_vertex    = mesh.base_vertex(),
+        .base_instance  = draw_id,
+    });
+    _draws_count++;
+    _instances_count += instances_count;
+    return draw_id;
+}
+
+void DrawBatch::clear()
+{
+    for (auto& group : _groups)
+        group.commands.clear();
+    _draws_count     = 0;
+    _instances_count = 0;
+}
+
+void DrawBatch::submit(std::span<std::byte const> draw_data, GLuint draw_data_binding) const
+{
+    if (_draws_count == 0)
+        return;
+
+    _all_commands.clear();
+    for (auto const& group : _groups)
+        _all_commands.insert(_all_commands.end(), group.commands.begin(), group.commands.end());
+    upload(GL_DRAW_INDIRECT_BUFFER, _indirect_buffer.id(), _indirect_buffer_capacity, std::as_bytes(std::span{_all_commands}));
+
+    if (!draw_data.empty())
+    {
+        upload(GL_SHADER_STORAGE_BUFFER, _draw_data_buffer.id(), _draw_data_buffer_capacity, draw_data);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, draw_data_binding, _draw_data_buffer.id());
+    }
+
+    // gl_DrawID and gl_BaseInstance are not available in OpenGL 4.3 shaders, so each instance reads its id from a buffer containing 0, 1, 2, ...
+    // Thanks to the divisor, instance i of a draw reads element base_instance + i.
+    glBindBuffer(GL_ARRAY_BUFFER, _draw_ids_buffer.id());
+    if (_instances_count > _draw_ids_count)
+    {
+        _draw_ids_count = std::bit_ceil(_instances_count);
+        auto ids        = std::vector<GLuint>(_draw_ids_count);
+        std::iota(ids.begin(), ids.end(), GLuint{0});
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(ids.size() * sizeof(GLuint)), ids.data(), GL_STATIC_DRAW);
+    }
+
+    size_t offset = 0;
+    for (auto const& group : _groups)
+    {
+        if (group.commands.empty())
+            continue;
+        group.pool->bind_arena(group.arena_index);
+        glEnableVertexAttribArray(_draw_id_location);
+        glVertexAttribIPointer(_draw_id_location, 1, GL_UNSIGNED_INT, 0, nullptr);
+        glVertexAttribDivisor(_draw_id_location, 1);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<void*>(offset * sizeof(DrawElementsIndirectCommand)), static_cast<GLsizei>(group.commands.size()), 0); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+        // The arena VAOs are shared with SharedMesh::draw() and with the other batches, don't leave our instanced attribute enabled in them
+        glVertexAttribDivisor(_draw_id_location, 0);
+        glDisableVertexAttribArray(_draw_id_location);
+        offset += group.commands.size();
+    }
+}
+
+} // namespace gl
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "MeshPool.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+/// The struct that glMultiDrawElementsIndirect() reads from the GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    GLuint count{};          /// Number of indices
+    GLuint instance_count{};
+    GLuint first_index{};
+    GLint  base_vertex{};
+    GLuint base_instance{};
+};
+
+struct DrawBatch_Options {
+    /// The vertex shader receives the index of the draw as `layout(location = draw_id_location) in uint in_draw_id;`
+    /// It must not be used by the layout of the meshes.
+    GLuint draw_id_location{15};
+};
+
+/// Accumulates draws of SharedMeshes, and submits them all at once with glMultiDrawElementsIndirect(): one call per arena of the MeshPools, instead of one per mesh.
+/// Requires OpenGL 4.3, so it isn't available on MacOS.
+/// Each instance of each draw gets its own `in_draw_id`, which the shader can use to read per-draw data (e.g. a model matrix) from the SSBO given to submit():
+///
+/// layout(std430, binding = 0) buffer DrawData { mat4 model_matrices[]; };
+/// ... model_matrices[in_draw_id] ...
+class DrawBatch {
+public:
+    explicit DrawBatch(DrawBatch_Options const& = {});
+
+    /// Returns the `in_draw_id` of the first instance. The following instances have consecutive ids.
+    auto add(SharedMesh const&, GLuint instances_count = 1) -> GLuint;
+    /// Removes all the draws, so that you can start the next frame. Keeps the memory allocated.
+    void clear();
+
+    /// Issues all the draws. Element i of `draw_data` is the data of `in_draw_id` i, and is bound to the `draw_data_binding` of GL_SHADER_STORAGE_BUFFER.
+    void submit(std::span<std::byte const> draw_data = {}, GLuint draw_data_binding = 0) const;
+    template<typename DrawData>
+    void submit(std::span<DrawData const> draw_data, GLuint draw_data_binding = 0) const
+    {
+        submit(std::as_bytes(draw_data), draw_data_binding);
+    }
+
+    auto draws_count() const -> size_t { return _draws_count; }
+    auto instances_count() const -> GLuint { return _instances_count; }
+
+private:
+    /// The draws that use the same vertex array
+    struct Group {
+        MeshPool const*                          pool{};
+        size_t                                   arena_index{};
+        std::vector<DrawElementsIndirectCommand> commands{};
+    };
+    std::vector<Group> _groups{};
+    size_t             _draws_count{0};
+    GLuint             _instances_count{0};
+    GLuint             _draw_id_location;
+
+    mutable std::vector<DrawElementsIndirectCommand> _all_commands{}; /// Only kept to avoid reallocating every frame
+    mutable internal::UniqueBuffer                   _indirect_buffer{};
+    mutable size_t                                   _indirect_buffer_capacity{0}; /// In bytes
+    mutable internal::UniqueBuffer                   _draw_ids_buffer{};
+    mutable GLuint                                   _draw_ids_count{0};
+    mutable internal::UniqueBuffer                   _draw_data_buffer{};
+    mutable size_t                                   _draw_data_buffer_capacity{0}; /// In bytes
+};
+
+} // namespace gl
@@ -0,0 +1,39 @@
+#include "FixedTimestep.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace gl {
+
+FixedTimestep::FixedTimestep(FixedTimestep_Options const& options)
+    : _options{options}
+{
+    assert(options.step_in_seconds > 0.f);
+    assert(options.max_steps_per_frame > 0);
+}
+
+void FixedTimestep::add_frame_time(float delta_time_in_seconds)
+{
+    _accumulator += std::max(static_cast<double>(delta_time_in_seconds), 0.);
+    double const max_time = static_cast<double>(_options.step_in_seconds) * _options.max_steps_per_frame;
+    if (_accumulator > max_time)
+    {
+        _dropped_time += _accumulator - max_time;
+        _accumulator = max_time;
+    }
+}
+
+auto FixedTimestep::step() -> bool
+{
+    if (_accumulator < static_cast<double>(_options.step_in_seconds))
+        return false;
+    _accumulator -= static_cast<double>(_options.step_in_seconds);
+    _steps_count++;
+    return true;
+}
+
+auto FixedTimestep::interpolation_factor() const -> float
+{
+    return std::clamp(static_cast<float>(_accumulator / static_cast<double>(_options.step_in_seconds)), 0.f, 1.f);
+}
+
+} // namespace gl
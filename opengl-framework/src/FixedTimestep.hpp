@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+namespace gl {
+
+struct FixedTimestep_Options {
+    float step_in_seconds{1.f / 120.f};
+    int   max_steps_per_frame{8}; /// When a frame took too long, the simulation slows down instead of trying to catch up. Otherwise each frame would need more steps than the previous one (the "spiral of death").
+};
+
+/// Runs a simulation at a fixed rate, independently of the frame rate, so that it behaves the same whatever the rendering load, and stays stable when a frame takes too long.
+/// Use it like so:
+/// ```
+/// while (gl::window_is_open())
+/// {
+///     timestep.add_frame_time(gl::delta_time_in_seconds());
+///     while (timestep.step())
+///         simulate(timestep.step_in_seconds());
+///     render(glm::mix(previous_state, current_state, timestep.interpolation_factor()));
+/// }
+/// ```
+/// This doesn't depend on the window, so it can also drive a simulation without any rendering.
+class FixedTimestep {
+public:
+    explicit FixedTimestep(FixedTimestep_Options const& = {});
+
+    /// Adds the time that elapsed since the previous frame. Time that would require more than max_steps_per_frame steps is dropped.
+    void add_frame_time(float delta_time_in_seconds);
+    /// Must only be used as the condition of a while loop. Returns true while there is still a step to simulate for this frame.
+    [[nodiscard]] auto step() -> bool;
+
+    auto step_in_seconds() const -> float { return _options.step_in_seconds; }
+    /// Between 0 and 1: where the current time is, between the last two steps. Use it to interpolate between the previous state and the current state when rendering, otherwise the motion looks jerky when the frame rate and the simulation rate don't match.
+    auto interpolation_factor() const -> float;
+    /// Number of steps that have been simulated since the creation of the timestep
+    auto steps_count() const -> uint64_t { return _steps_count; }
+    /// Total time that has been dropped because of max_steps_per_frame
+    auto dropped_time_in_seconds() const -> double { return _dropped_time; }
+
+private:
+    FixedTimestep_Options _options;
+    double                _accumulator{0.}; /// Time that hasn't been simulated yet. Doubles, so that rounding errors don't accumulate.
+    double                _dropped_time{0.};
+    uint64_t              _steps_count{0};
+};
+
+} // namespace gl
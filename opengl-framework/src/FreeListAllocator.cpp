@@ -0,0 +1,77 @@
+#include "FreeListAllocator.hpp"
+#include <cassert>
+#include <iterator>
+
+namespace gl::internal {
+
+FreeListAllocator::FreeListAllocator(size_t capacity)
+    : _capacity{capacity}
+{
+    if (capacity > 0)
+        insert_free_range(0, capacity);
+}
+
+auto FreeListAllocator::allocate(size_t size) -> std::optional<size_t>
+{
+    assert(size > 0);
+    auto const best_fit = _free_ranges_by_size.lower_bound(size); // The smallest free range that is big enough
+    if (best_fit == _free_ranges_by_size.end())
+        return std::nullopt;
+
+    size_t const offset     = best_fit->second;
+    size_t const range_size = best_fit->first;
+    erase_free_range(_free_ranges_by_offset.find(offset));
+    if (range_size > size)
+        insert_free_range(offset + size, range_size - size);
+    _used_size += size;
+    return offset;
+}
+
+void FreeListAllocator::free(size_t offset, size_t size)
+{
+    assert(offset + size <= _capacity);
+    _used_size -= size;
+
+    // Merge with the free ranges right after and right before
+    auto next = _free_ranges_by_offset.lower_bound(offset);
+    assert((next == _free_ranges_by_offset.end() || offset + size <= next->first) && "This range has already been freed");
+    if (next != _free_ranges_by_offset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        erase_free_range(next);
+    }
+    auto const after = _free_ranges_by_offset.lower_bound(offset);
+    if (after != _free_ranges_by_offset.begin())
+    {
+        auto const previous = std::prev(after);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            erase_free_range(previous);
+        }
+    }
+    insert_free_range(offset, size);
+}
+
+void FreeListAllocator::insert_free_range(size_t offset, size_t size)
+{
+    _free_ranges_by_offset.emplace(offset, size);
+    _free_ranges_by_size.emplace(size, offset);
+}
+
+void FreeListAllocator::erase_free_range(std::map<size_t, size_t>::iterator range)
+{
+    auto [begin, end] = _free_ranges_by_size.equal_range(range->second);
+    for (auto it = begin; it != end; ++it)
+    {
+        if (it->second == range->first)
+        {
+            _free_ranges_by_size.erase(it);
+            break;
+        }
+    }
+    _free_ranges_by_offset.erase(range);
+}
+
+} // namespace gl::internal
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <optional>
+
+namespace gl::internal {
+
+/// Hands out ranges of [0, capacity), and takes them back. It only does the bookkeeping: the memory itself lives elsewhere (e.g. in a GPU buffer).
+/// Uses best-fit, and merges neighbouring free ranges, which keeps fragmentation low for the typical mesh loading / unloading patterns.
+class FreeListAllocator {
+public:
+    explicit FreeListAllocator(size_t capacity);
+
+    /// Returns the offset of the range, or std::nullopt if there is no free range big enough.
+    auto allocate(size_t size) -> std::optional<size_t>;
+    /// `offset` and `size` must be exactly the ones of a previous allocation.
+    void free(size_t offset, size_t size);
+
+    auto capacity() const -> size_t { return _capacity; }
+    auto used_size() const -> size_t { return _used_size; }
+
+private:
+    void insert_free_range(size_t offset, size_t size);
+    void erase_free_range(std::map<size_t, size_t>::iterator range);
+
+private:
+    size_t                        _capacity;
+    size_t                        _used_size{0};
+    std::map<size_t, size_t>      _free_ranges_by_offset{}; /// offset -> size
+    std::multimap<size_t, size_t> _free_ranges_by_size{};   /// size -> offset
+};
+
+} // namespace gl::internal
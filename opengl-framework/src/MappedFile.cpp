@@ -0,0 +1,116 @@
+#include "MappedFile.hpp"
+#include <utility>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gl::internal {
+
+#if defined(_WIN32)
+
+auto MappedFile::open(std::filesystem::path const& path) -> std::optional<MappedFile>
+{
+    auto res         = MappedFile{};
+    res._file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (res._file_handle == INVALID_HANDLE_VALUE)
+    {
+        res._file_handle = nullptr;
+        return std::nullopt;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(res._file_handle, &size) || size.QuadPart == 0)
+        return std::nullopt;
+    res._size           = static_cast<size_t>(size.QuadPart);
+    res._mapping_handle = CreateFileMappingW(res._file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!res._mapping_handle)
+        return std::nullopt;
+    res._data = MapViewOfFile(res._mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!res._data)
+        return std::nullopt;
+    return res;
+}
+
+void MappedFile::unmap()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping_handle)
+        CloseHandle(_mapping_handle);
+    if (_file_handle)
+        CloseHandle(_file_handle);
+    _data           = nullptr;
+    _mapping_handle = nullptr;
+    _file_handle    = nullptr;
+    _size           = 0;
+}
+
+#else
+
+auto MappedFile::open(std::filesystem::path const& path) -> std::optional<MappedFile>
+{
+    int const fd = ::open(path.c_str(), O_RDONLY); // NOLINT(*vararg)
+    if (fd < 0)
+        return std::nullopt;
+
+    struct stat file_stats{};
+    void*       data = MAP_FAILED;
+    if (fstat(fd, &file_stats) == 0 && file_stats.st_size > 0)
+        data = mmap(nullptr, static_cast<size_t>(file_stats.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping stays valid after the file is closed
+    if (data == MAP_FAILED) // NOLINT(*cstyle-cast, performance-no-int-to-ptr)
+        return std::nullopt;
+
+    auto res  = MappedFile{};
+    res._data = data;
+    res._size = static_cast<size_t>(file_stats.st_size);
+    return res;
+}
+
+void MappedFile::unmap()
+{
+    if (_data)
+        munmap(_data, _size);
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& o) noexcept
+    : _data{std::exchange(o._data, nullptr)}
+    , _size{std::exchange(o._size, 0)}
+#if defined(_WIN32)
+    , _file_handle{std::exchange(o._file_handle, nullptr)}
+    , _mapping_handle{std::exchange(o._mapping_handle, nullptr)}
+#endif
+{
+}
+
+auto MappedFile::operator=(MappedFile&& o) noexcept -> MappedFile&
+{
+    if (this != &o)
+    {
+        unmap();
+        _data = std::exchange(o._data, nullptr);
+        _size = std::exchange(o._size, 0);
+#if defined(_WIN32)
+        _file_handle    = std::exchange(o._file_handle, nullptr);
+        _mapping_handle = std::exchange(o._mapping_handle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+} // namespace gl::internal
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace gl::internal {
+
+/// Read-only memory mapping of a whole file: its bytes can be accessed directly, without copying them into a buffer first.
+class MappedFile {
+public:
+    /// Returns std::nullopt if the file doesn't exist or can't be mapped.
+    static auto open(std::filesystem::path const&) -> std::optional<MappedFile>;
+
+    ~MappedFile();
+    MappedFile(MappedFile const&)                    = delete; // You cannot copy
+    auto operator=(MappedFile const&) -> MappedFile& = delete; // a MappedFile. But you can move it, using std::move(my_file)
+    MappedFile(MappedFile&&) noexcept;
+    auto operator=(MappedFile&&) noexcept -> MappedFile&;
+
+    auto bytes() const -> std::span<std::byte const> { return {static_cast<std::byte const*>(_data), _size}; }
+
+private:
+    MappedFile() = default;
+    void unmap();
+
+private:
+    void*  _data{nullptr};
+    size_t _size{0};
+#if defined(_WIN32)
+    void* _file_handle{nullptr};
+    void* _mapping_handle{nullptr};
+#endif
+};
+
+} // namespace gl::internal
@@ -1,78 +1,197 @@
 #include "Mesh.hpp"
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #include <numeric>
 #include <opengl-framework/opengl-framework.hpp>
 
 namespace gl {
 
-static auto index(AnyVertexAttribute const& attr)
+namespace internal {
+
+/// Visits each attribute once, so that the upload doesn't have to
+auto vertex_members(std::vector<AnyVertexAttribute> const& layout) -> std::vector<VertexMember>
+{
+    auto   res    = std::vector<VertexMember>{};
+    size_t offset = 0;
+    for (auto const& attribute : layout)
+    {
+        auto const member = std::visit([&](auto&& attr) {
+            return vertex_member<std::remove_cvref_t<decltype(attr)>>(static_cast<GLuint>(attr.index()), offset);
+        },
+                                       attribute);
+        res.push_back(member);
+        offset += static_cast<size_t>(member.size_in_bytes);
+    }
+    return res;
+}
+
+auto vertex_stride(std::span<VertexMember const> members) -> GLsizei
+{
+    return std::accumulate(members.begin(), members.end(), 0, [](GLsizei acc, VertexMember const& member) {
+        return acc + member.size_in_bytes;
+    });
+}
+
+void set_vertex_attributes(std::span<VertexMember const> members, GLsizei stride, GLuint divisor)
 {
-    return std::visit([](auto&& attr) { return attr.index(); }, attr);
+    for (auto const& member : members)
+    {
+        glEnableVertexAttribArray(member.location);
+        if (member.is_integer())
+            glVertexAttribIPointer(member.location, member.components_count, member.type, stride, reinterpret_cast<void*>(member.offset)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+        else
+            glVertexAttribPointer(member.location, member.components_count, member.type, member.normalized, stride, reinterpret_cast<void*>(member.offset)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+        glVertexAttribDivisor(member.location, divisor);
+    }
 }
-static auto size(AnyVertexAttribute const& attr)
+
+auto compute_position_bounds(std::span<std::byte const> vertices, std::span<VertexMember const> members, GLsizei stride) -> std::optional<Bounds>
 {
-    return std::visit([](auto&& attr) { return attr.size(); }, attr);
+    auto const position = std::find_if(members.begin(), members.end(), [](VertexMember const& member) {
+        return member.location == 0 && member.type == GL_FLOAT && (member.components_count == 2 || member.components_count == 3);
+    });
+    if (position == members.end())
+        return std::nullopt;
+    return compute_bounds(vertices, static_cast<size_t>(stride), position->offset, position->components_count);
 }
-static auto type(AnyVertexAttribute const& attr)
+
+} // namespace internal
+
+static auto size_in_bytes(IndexType type) -> size_t
 {
-    return std::visit([](auto&& attr) { return attr.type(); }, attr);
+    return type == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
 }
-static auto size_in_bytes(AnyVertexAttribute const& attr)
+
+auto smallest_index_type(size_t vertices_count) -> IndexType
 {
-    return size(attr) * 4;
+    return vertices_count <= size_t{std::numeric_limits<uint16_t>::max()} + 1
+               ? IndexType::UInt16
+               : IndexType::UInt32;
 }
 
 Mesh::Mesh(Mesh_Descriptor desc)
 {
     assert(!desc.vertex_buffers.empty() && "You must provide at least one vertex buffer to construct a mesh.");
+    glGenVertexArrays(1, &_vertex_array);
+    glBindVertexArray(_vertex_array);
 
+    for (auto const& vertex_buffer : desc.vertex_buffers)
+    {
+        auto const members = internal::vertex_members(vertex_buffer.layout);
+        add_vertex_buffer(std::as_bytes(std::span{vertex_buffer.data}), members, internal::vertex_stride(members));
+    }
     if (!desc.index_buffer.empty())
+        set_index_buffer(desc.index_buffer, _vertices_count);
+}
+
+Mesh::Mesh(Mesh_RawDescriptor desc)
+{
+    assert(!desc.vertex_buffers.empty() && "You must provide at least one vertex buffer to construct a mesh.");
+    glGenVertexArrays(1, &_vertex_array);
+    glBindVertexArray(_vertex_array);
+
+    for (auto const& vertex_buffer : desc.vertex_buffers)
     {
-        assert(desc.index_buffer.size() % 3 == 0 && "You must provide 3 indices for each triangle");
-        _triangles_count = desc.index_buffer.size() / 3;
+        auto const members = internal::vertex_members(vertex_buffer.layout);
+        add_vertex_buffer(vertex_buffer.data, members, internal::vertex_stride(members));
     }
+    if (!desc.index_buffer.empty())
+        set_index_buffer(desc.index_buffer, desc.index_type);
+}
+
+Mesh::Mesh(std::span<VertexMember const> members, GLsizei stride, std::span<std::byte const> vertices, std::span<uint32_t const> indices)
+{
+    glGenVertexArrays(1, &_vertex_array);
+    glBindVertexArray(_vertex_array);
 
-    { // Vertex Array
-        glGenVertexArrays(1, &_vertex_array);
-        glBindVertexArray(_vertex_array);
+    add_vertex_buffer(vertices, members, stride);
+    if (!indices.empty())
+        set_index_buffer(indices, _vertices_count);
+}
+
+void Mesh::add_vertex_buffer(std::span<std::byte const> data, std::span<VertexMember const> members, GLsizei stride)
+{
+    auto const vertices_count = data.size() / static_cast<size_t>(stride);
+    if (_vertex_buffers.empty())
+    {
+        _vertices_count  = vertices_count;
+        _triangles_count = vertices_count / 3; // Until we get an index buffer
+    }
+    else
+    {
+        assert(_vertices_count == vertices_count && "Some vertex buffers contain more vertices than others! Make sure that their data is correct, and that the layout matches the data.");
     }
 
-    { // Vertex Buffers
-        _vertex_buffers.resize(desc.vertex_buffers.size());
-        glGenBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
-        for (size_t i = 0; i < _vertex_buffers.size(); ++i)
-        {
-            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffers[i]);
-            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(desc.vertex_buffers[i].data.size() * sizeof(GLfloat)), desc.vertex_buffers[i].data.data(), GL_STATIC_DRAW);
-
-            int const stride = std::accumulate(desc.vertex_buffers[i].layout.begin(), desc.vertex_buffers[i].layout.end(), 0, [](int acc, AnyVertexAttribute const& attr) {
-                return acc + size_in_bytes(attr);
-            });
-            if (desc.index_buffer.empty())
-            {
-                auto const triangles_count = desc.vertex_buffers[i].data.size() / (stride / sizeof(float)) / 3;
-                if (i == 0)
-                    _triangles_count = triangles_count;
-                else
-                    assert(_triangles_count == triangles_count && "Some vertex buffers contain more vertices than others! Make sure that their data is correct, and that the layout matches the data.");
-            }
-            uint64_t pointer{0};
-            for (auto const& attribute : desc.vertex_buffers[i].layout)
-            {
-                glEnableVertexAttribArray(index(attribute));
-                glVertexAttribPointer(index(attribute), size(attribute), type(attribute), GL_FALSE, stride, reinterpret_cast<void*>(pointer)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
-                pointer += size_in_bytes(attribute);
-            }
-        }
+    if (!_bounds)
+        _bounds = internal::compute_position_bounds(data, members, stride);
+
+    GLuint& buffer = _vertex_buffers.emplace_back();
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STATIC_DRAW);
+    internal::set_vertex_attributes(members, stride, 0);
+}
+
+auto Mesh::add_instance_buffer(std::vector<AnyVertexAttribute> const& layout, std::span<std::byte const> data, GLuint divisor) -> size_t
+{
+    auto const members = internal::vertex_members(layout);
+    return add_instance_buffer(members, internal::vertex_stride(members), data, divisor);
+}
+
+auto Mesh::add_instance_buffer(std::span<VertexMember const> members, GLsizei stride, std::span<std::byte const> data, GLuint divisor) -> size_t
+{
+    assert(divisor > 0 && "A divisor of 0 would make the attributes advance once per vertex. Use a regular vertex buffer instead.");
+    glBindVertexArray(_vertex_array);
+
+    auto& buffer = _instance_buffers.emplace_back(InstanceBuffer{.id = 0, .capacity = data.size()});
+    glGenBuffers(1, &buffer.id);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.empty() ? nullptr : data.data(), GL_STREAM_DRAW);
+    internal::set_vertex_attributes(members, stride, divisor);
+    return _instance_buffers.size() - 1;
+}
+
+void Mesh::update_instance_buffer(size_t buffer_index, std::span<std::byte const> data)
+{
+    assert(buffer_index < _instance_buffers.size() && "This instance buffer doesn't exist. Use the index returned by add_instance_buffer().");
+    auto& buffer = _instance_buffers[buffer_index];
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+    if (data.size() > buffer.capacity)
+    {
+        buffer.capacity = data.size();
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STREAM_DRAW);
     }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(buffer.capacity), nullptr, GL_STREAM_DRAW); // Orphan the previous storage
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+    }
+}
+
+void Mesh::set_index_buffer(std::span<std::byte const> data, IndexType index_type)
+{
+    auto const indices_count = data.size() / size_in_bytes(index_type);
+    assert(indices_count % 3 == 0 && "You must provide 3 indices for each triangle");
+    _triangles_count = indices_count / 3;
+    _index_type      = index_type;
+
+    glGenBuffers(1, &_maybe_index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _maybe_index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STATIC_DRAW);
+}
 
-    { // Index Buffer
-        if (!desc.index_buffer.empty())
-        {
-            glGenBuffers(1, &_maybe_index_buffer);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _maybe_index_buffer);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(desc.index_buffer.size() * sizeof(uint32_t)), desc.index_buffer.data(), GL_STATIC_DRAW);
-        }
+void Mesh::set_index_buffer(std::span<uint32_t const> indices, size_t vertices_count)
+{
+    if (smallest_index_type(vertices_count) == IndexType::UInt16)
+    {
+        // Halves the size of the index buffer
+        auto const indices_16_bit = std::vector<uint16_t>(indices.begin(), indices.end());
+        set_index_buffer(std::as_bytes(std::span{indices_16_bit}), IndexType::UInt16);
+    }
+    else
+    {
+        set_index_buffer(std::as_bytes(indices), IndexType::UInt32);
     }
 }
 
@@ -80,28 +199,55 @@ void Mesh::draw() const
 {
     glBindVertexArray(_vertex_array);
     if (_maybe_index_buffer != 0)
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * _triangles_count), GL_UNSIGNED_INT, reinterpret_cast<void*>(0)); // NOLINT(*reinterpret-cast)
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * _triangles_count), static_cast<GLenum>(_index_type), reinterpret_cast<void*>(0)); // NOLINT(*reinterpret-cast)
     else
         glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(3 * _triangles_count));
 }
 
+void Mesh::draw_instanced(GLsizei instances_count, GLuint base_instance) const
+{
+    glBindVertexArray(_vertex_array);
+    auto const vertices_count = static_cast<GLsizei>(3 * _triangles_count);
+    if (_maybe_index_buffer != 0)
+    {
+        if (base_instance == 0)
+            glDrawElementsInstanced(GL_TRIANGLES, vertices_count, static_cast<GLenum>(_index_type), reinterpret_cast<void*>(0), instances_count); // NOLINT(*reinterpret-cast)
+        else
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, vertices_count, static_cast<GLenum>(_index_type), reinterpret_cast<void*>(0), instances_count, base_instance); // NOLINT(*reinterpret-cast)
+    }
+    else
+    {
+        if (base_instance == 0)
+            glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_count, instances_count);
+        else
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, vertices_count, instances_count, base_instance);
+    }
+}
+
 Mesh::~Mesh()
 {
     glDeleteVertexArrays(1, &_vertex_array);
     if (!_vertex_buffers.empty()) // Might have been moved-from
         glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
     glDeleteBuffers(1, &_maybe_index_buffer);
+    for (auto const& buffer : _instance_buffers)
+        glDeleteBuffers(1, &buffer.id);
 }
 
 Mesh::Mesh(Mesh&& o) noexcept
     : _vertex_array{o._vertex_array}
     , _vertex_buffers{std::move(o._vertex_buffers)}
     , _maybe_index_buffer{o._maybe_index_buffer}
+    , _index_type{o._index_type}
+    , _instance_buffers{std::move(o._instance_buffers)}
+    , _vertices_count{o._vertices_count}
     , _triangles_count{o._triangles_count}
+    , _bounds{o._bounds}
 {
     o._vertex_array = 0;
     o._vertex_buffers.resize(0);
     o._maybe_index_buffer = 0;
+    o._instance_buffers.clear();
 }
 
 auto Mesh::operator=(Mesh&& o) noexcept -> Mesh&
@@ -113,16 +259,23 @@ auto Mesh::operator=(Mesh&& o) noexcept -> Mesh&
         if (!_vertex_buffers.empty()) // Might have been moved-from
             glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
         glDeleteBuffers(1, &_maybe_index_buffer);
+        for (auto const& buffer : _instance_buffers)
+            glDeleteBuffers(1, &buffer.id);
 
         // Move
         _vertex_array       = o._vertex_array;
         _vertex_buffers     = std::move(o._vertex_buffers);
         _maybe_index_buffer = o._maybe_index_buffer;
+        _index_type         = o._index_type;
+        _instance_buffers   = std::move(o._instance_buffers);
+        _vertices_count     = o._vertices_count;
         _triangles_count    = o._triangles_count;
+        _bounds             = o._bounds;
 
         o._vertex_array = 0;
         o._vertex_buffers.resize(0);
         o._maybe_index_buffer = 0;
+        o._instance_buffers.clear();
     }
     return *this;
 }
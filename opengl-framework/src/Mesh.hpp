@@ -1,6 +1,13 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <type_traits>
 #include <variant>
 #include <vector>
+#include "bounds.hpp"
 #include "glad/gl.h"
 
 namespace gl {
@@ -23,50 +30,161 @@ namespace VertexAttribute {
 class Float : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 1; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 1; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class Vec2 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 2; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class Vec3 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 3; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 3; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size_in_bytes() -> GLint { return 12; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class Vec4 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 4; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size_in_bytes() -> GLint { return 16; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class Int : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 1; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 1; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class IVec2 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 2; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class IVec3 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 3; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 3; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size_in_bytes() -> GLint { return 12; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
 };
 class IVec4 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 4; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size_in_bytes() -> GLint { return 16; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+};
+
+// ---Compact attributes---
+// They are read as floats (or vecN) by the shader, but take less memory and bandwidth than GL_FLOAT attributes.
+// You can use the packing functions of glm (from <glm/packing.hpp> and <glm/gtc/packing.hpp>) to convert your data into these formats.
+
+/// Two 16-bit floats. Great for UVs. Use glm::packHalf2x16() to create them.
+class Half2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_HALF_FLOAT; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+};
+/// Four 16-bit floats. Use glm::packHalf4x16() to create them.
+class Half4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_HALF_FLOAT; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+};
+/// Four 8-bit values in [0, 1]. Great for colors. Use glm::packUnorm4x8() to create them.
+class UNorm8x4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_UNSIGNED_BYTE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// Four 8-bit values in [-1, 1]. Use glm::packSnorm4x8() to create them.
+class SNorm8x4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_BYTE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// Two 16-bit values in [0, 1]. Great for UVs that don't repeat. Use glm::packUnorm2x16() to create them.
+class UNorm16x2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_UNSIGNED_SHORT; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// Two 16-bit values in [-1, 1]. Use glm::packSnorm2x16() to create them.
+class SNorm16x2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_SHORT; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// Four 16-bit values in [0, 1]. Use glm::packUnorm4x16() to create them.
+class UNorm16x4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_UNSIGNED_SHORT; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// Four 16-bit values in [-1, 1]. Use glm::packSnorm4x16() to create them.
+class SNorm16x4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_SHORT; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// x, y and z on 10 bits and w on 2 bits, all in [-1, 1], packed in 32 bits. Great for normals and tangents. Use glm::packSnorm3x10_1x2() to create them.
+class SNorm10_10_10_2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_INT_2_10_10_10_REV; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// x, y and z on 10 bits and w on 2 bits, all in [0, 1], packed in 32 bits. Great for colors. Use glm::packUnorm3x10_1x2() to create them.
+class UNorm10_10_10_2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_UNSIGNED_INT_2_10_10_10_REV; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
 };
 
 using Position2D = Vec2;
@@ -85,7 +203,17 @@ using AnyVertexAttribute = std::variant<
     VertexAttribute::Int,
     VertexAttribute::IVec2,
     VertexAttribute::IVec3,
-    VertexAttribute::IVec4>;
+    VertexAttribute::IVec4,
+    VertexAttribute::Half2,
+    VertexAttribute::Half4,
+    VertexAttribute::UNorm8x4,
+    VertexAttribute::SNorm8x4,
+    VertexAttribute::UNorm16x2,
+    VertexAttribute::SNorm16x2,
+    VertexAttribute::UNorm16x4,
+    VertexAttribute::SNorm16x4,
+    VertexAttribute::SNorm10_10_10_2,
+    VertexAttribute::UNorm10_10_10_2>;
 
 struct VertexBuffer_Descriptor {
     std::vector<AnyVertexAttribute> const& layout; // NOLINT(*avoid-const-or-ref-data-members)
@@ -97,9 +225,104 @@ struct Mesh_Descriptor {
     std::vector<uint32_t> const&                index_buffer{};
 };
 
+enum class IndexType : GLenum {
+    UInt16 = GL_UNSIGNED_SHORT,
+    UInt32 = GL_UNSIGNED_INT,
+};
+
+/// Returns UInt16 if all the vertices can be indexed with 16 bits, and UInt32 otherwise.
+auto smallest_index_type(size_t vertices_count) -> IndexType;
+
+/// Same as VertexBuffer_Descriptor, but the data is given as raw bytes. This allows you to upload data that doesn't come from a std::vector<float>, without any copy.
+struct VertexBuffer_RawDescriptor {
+    std::vector<AnyVertexAttribute> const& layout; // NOLINT(*avoid-const-or-ref-data-members)
+    std::span<std::byte const>             data{};
+};
+
+/// Same as Mesh_Descriptor, but the data is given as raw bytes. This allows you to upload data that doesn't come from a std::vector, without any copy, and to use 16-bit indices.
+struct Mesh_RawDescriptor {
+    std::vector<VertexBuffer_RawDescriptor> const& vertex_buffers; // NOLINT(*avoid-const-or-ref-data-members)
+    std::span<std::byte const>                     index_buffer{};
+    IndexType                                      index_type{IndexType::UInt32};
+};
+
+/// Describes one member of a vertex struct, see VertexDescription.
+struct VertexMember {
+    GLuint    location{};         /// Location in the shader
+    GLint     components_count{}; /// Number of components read by the shader (e.g. 3 for a vec3)
+    GLenum    type{};             /// Type of each component, as stored in memory
+    GLboolean normalized{};       /// Whether integer types are remapped to [0, 1] or [-1, 1]
+    GLint     size_in_bytes{};
+    size_t    offset{}; /// offsetof() the member in the vertex struct
+
+    constexpr auto is_integer() const -> bool { return type == GL_INT; }
+
+    friend constexpr auto operator==(VertexMember const&, VertexMember const&) -> bool = default;
+};
+
+namespace internal {
+auto vertex_members(std::vector<AnyVertexAttribute> const& layout) -> std::vector<VertexMember>;
+auto vertex_stride(std::span<VertexMember const> members) -> GLsizei;
+/// Describes the members to the currently bound vertex array, reading from the currently bound GL_ARRAY_BUFFER.
+void set_vertex_attributes(std::span<VertexMember const> members, GLsizei stride, GLuint divisor);
+/// Bounds of the positions, which are expected to be 2 or 3 floats at location 0. Returns std::nullopt if there is no such member.
+auto compute_position_bounds(std::span<std::byte const> vertices, std::span<VertexMember const> members, GLsizei stride) -> std::optional<Bounds>;
+} // namespace internal
+
+/// Creates the description of a vertex member that will be read as an `Attribute` (one of the classes in gl::VertexAttribute).
+/// e.g. gl::vertex_member<gl::VertexAttribute::Vec3>(0, offsetof(MyVertex, position))
+template<typename Attribute>
+constexpr auto vertex_member(GLuint location, size_t offset) -> VertexMember
+{
+    return {
+        .location         = location,
+        .components_count = Attribute::size(),
+        .type             = Attribute::type(),
+        .normalized       = Attribute::normalized(),
+        .size_in_bytes    = Attribute::size_in_bytes(),
+        .offset           = offset,
+    };
+}
+
+/// Specialize it to describe your vertex struct, so that it can be used with Mesh::from_vertices():
+///
+/// struct MyVertex {
+///     glm::vec3 position;
+///     uint32_t  normal; // Packed with glm::packSnorm3x10_1x2()
+/// };
+/// template<>
+/// struct gl::VertexDescription<MyVertex> {
+///     static constexpr auto members = std::array{
+///         gl::vertex_member<gl::VertexAttribute::Position3D>(0, offsetof(MyVertex, position)),
+///         gl::vertex_member<gl::VertexAttribute::SNorm10_10_10_2>(1, offsetof(MyVertex, normal)),
+///     };
+/// };
+template<typename Vertex>
+struct VertexDescription;
+
+template<typename Vertex>
+concept DescribedVertex = std::is_trivially_copyable_v<Vertex> && requires { VertexDescription<Vertex>::members; };
+
 class Mesh {
 public:
+    /// Uploads an array of structs, whose layout is known at compile time thanks to VertexDescription<Vertex>. The vertices are uploaded as is, without any conversion.
+    /// If `indices` is empty, each group of 3 vertices is a triangle. Otherwise, 16-bit indices are used if there are few enough vertices.
+    /// Usage: gl::Mesh::from_vertices<MyVertex>(my_vertices, my_indices)
+    template<DescribedVertex Vertex>
+    static auto from_vertices(std::span<Vertex const> vertices, std::span<uint32_t const> indices = {}) -> Mesh
+    {
+        static constexpr auto const& members = VertexDescription<Vertex>::members;
+        static_assert(std::all_of(std::begin(members), std::end(members), [](VertexMember const& member) {
+                          return member.offset + static_cast<size_t>(member.size_in_bytes) <= sizeof(Vertex);
+                      }),
+                      "A member of the VertexDescription doesn't fit inside the Vertex struct. Did you use the right offsetof() and attribute type?");
+        return Mesh{members, static_cast<GLsizei>(sizeof(Vertex)), std::as_bytes(vertices), indices};
+    }
+
+
+    /// If there are few enough vertices, the indices are converted to 16 bits before being uploaded.
     explicit Mesh(Mesh_Descriptor);
+    explicit Mesh(Mesh_RawDescriptor);
     ~Mesh();
     Mesh(Mesh const&)                    = delete; // You cannot copy
     auto operator=(Mesh const&) -> Mesh& = delete; // a Mesh. But you can move it, using std::move(my_mesh)
@@ -107,13 +330,52 @@ public:
     auto operator=(Mesh&&) noexcept -> Mesh&;
 
     void draw() const;
+    /// In model space. They are computed from the positions (2 or 3 floats at location 0) when the mesh is created, and are std::nullopt if the mesh has no such positions.
+    auto bounds() const -> std::optional<Bounds> const& { return _bounds; }
+    /// Draws `instances_count` copies of the mesh in a single draw call. The shader can tell them apart with gl_InstanceID, or with instance buffers.
+    /// The instance attributes start at element `base_instance` of their buffers (a non-zero base_instance requires OpenGL 4.2, so it isn't available on MacOS).
+    void draw_instanced(GLsizei instances_count, GLuint base_instance = 0) const;
+
+    /// Attaches a buffer whose attributes advance once every `divisor` instances, instead of once per vertex.
+    /// Returns the index of the buffer, that you can pass to update_instance_buffer().
+    template<DescribedVertex Instance>
+    auto add_instance_buffer(std::span<Instance const> instances = {}, GLuint divisor = 1) -> size_t
+    {
+        return add_instance_buffer(VertexDescription<Instance>::members, static_cast<GLsizei>(sizeof(Instance)), std::as_bytes(instances), divisor);
+    }
+    auto add_instance_buffer(std::vector<AnyVertexAttribute> const& layout, std::span<std::byte const> data = {}, GLuint divisor = 1) -> size_t;
+
+    /// Replaces the whole content of an instance buffer. It is meant to be called every frame:
+    /// the previous storage is orphaned, so that we never have to wait for the GPU to finish the draw calls that were reading it.
+    template<DescribedVertex Instance>
+    void update_instance_buffer(size_t buffer_index, std::span<Instance const> instances)
+    {
+        update_instance_buffer(buffer_index, std::as_bytes(instances));
+    }
+    void update_instance_buffer(size_t buffer_index, std::span<std::byte const> data);
+
+private:
+    Mesh(std::span<VertexMember const> members, GLsizei stride, std::span<std::byte const> vertices, std::span<uint32_t const> indices);
+    void add_vertex_buffer(std::span<std::byte const> data, std::span<VertexMember const> members, GLsizei stride);
+    auto add_instance_buffer(std::span<VertexMember const> members, GLsizei stride, std::span<std::byte const> data, GLuint divisor) -> size_t;
+    void set_index_buffer(std::span<std::byte const> data, IndexType);
+    void set_index_buffer(std::span<uint32_t const> indices, size_t vertices_count);
 
 private:
     GLuint              _vertex_array{};
     std::vector<GLuint> _vertex_buffers{};
     GLuint              _maybe_index_buffer{};
+    IndexType           _index_type{IndexType::UInt32};
+
+    struct InstanceBuffer {
+        GLuint id{};
+        size_t capacity{}; /// In bytes
+    };
+    std::vector<InstanceBuffer> _instance_buffers{};
 
-    size_t _triangles_count{};
+    size_t                _vertices_count{};
+    size_t                _triangles_count{};
+    std::optional<Bounds> _bounds{};
 };
 
 } // namespace gl
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "MeshPool.hpp"
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include "handle_error.hpp"
+
+namespace gl {
+
+MeshPool::MeshPool(MeshPool_Descriptor const& desc)
+    : _members{internal::vertex_members(desc.layout)}
+    , _stride{internal::vertex_stride(_members)}
+    , _next_arena_vertices_count{desc.first_arena_vertices_count}
+    , _next_arena_indices_count{desc.first_arena_indices_count}
+    , _max_arena_vertices_count{desc.max_arena_vertices_count}
+    , _max_arena_indices_count{desc.max_arena_indices_count}
+{}
+
+auto MeshPool::shared(std::vector<AnyVertexAttribute> const& layout) -> MeshPool&
+{
+    static auto pools   = std::vector<std::unique_ptr<MeshPool>>{}; // unique_ptr, so that the pools never move
+    auto const  members = internal::vertex_members(layout);
+    auto const  it      = std::find_if(pools.begin(), pools.end(), [&](auto const& pool) {
+        return std::equal(members.begin(), members.end(), pool->_members.begin(), pool->_members.end());
+    });
+    if (it != pools.end())
+        return **it;
+    return *pools.emplace_back(std::make_unique<MeshPool>(MeshPool_Descriptor{.layout = layout}));
+}
+
+auto MeshPool::add_arena(size_t min_vertices_count, size_t min_indices_count) -> size_t
+{
+    auto& arena = _arenas.emplace_back(Arena{
+        .vertices = internal::FreeListAllocator{std::max(_next_arena_vertices_count, min_vertices_count)},
+        .indices  = internal::FreeListAllocator{std::max(_next_arena_indices_count, min_indices_count)},
+    });
+    // Start small, so that a few small meshes don't allocate a lot of memory, and grow geometrically, so that big scenes still only need a few arenas
+    _next_arena_vertices_count = std::min(2 * _next_arena_vertices_count, _max_arena_vertices_count);
+    _next_arena_indices_count  = std::min(2 * _next_arena_indices_count, _max_arena_indices_count);
+
+    glBindVertexArray(arena.vertex_array.id());
+    glBindBuffer(GL_ARRAY_BUFFER, arena.vertex_buffer.id());
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(arena.vertices.capacity() * static_cast<size_t>(_stride)), nullptr, GL_STATIC_DRAW);
+    internal::set_vertex_attributes(_members, _stride, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.index_buffer.id());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(arena.indices.capacity() * sizeof(uint32_t)), nullptr, GL_STATIC_DRAW);
+    return _arenas.size() - 1;
+}
+
+auto MeshPool::add(std::span<std::byte const> vertices, std::span<uint32_t const> indices) -> SharedMesh
+{
+    assert(vertices.size() % static_cast<size_t>(_stride) == 0 && "The vertices don't match the layout of the pool.");
+    assert(!indices.empty() && indices.size() % 3 == 0 && "You must provide 3 indices for each triangle");
+    auto const vertices_count = vertices.size() / static_cast<size_t>(_stride);
+    if (vertices_count == 0)
+        handle_error("[MeshPool] Cannot add a mesh without any vertex.");
+
+    // Use the first arena that has room for both the vertices and the indices
+    for (size_t arena_index = 0;; ++arena_index)
+    {
+        if (arena_index == _arenas.size())
+            add_arena(vertices_count, indices.size());
+        auto&      arena        = _arenas[arena_index];
+        auto const first_vertex = arena.vertices.allocate(vertices_count);
+        if (!first_vertex)
+            continue;
+        auto const first_index = arena.indices.allocate(indices.size());
+        if (!first_index)
+        {
+            arena.vertices.free(*first_vertex, vertices_count);
+            continue;
+        }
+
+        // Upload through GL_COPY_WRITE_BUFFER, so that we don't modify the index buffer of the vertex array that is currently bound
+        glBindBuffer(GL_COPY_WRITE_BUFFER, arena.vertex_buffer.id());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(*first_vertex * static_cast<size_t>(_stride)), static_cast<GLsizeiptr>(vertices.size()), vertices.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, arena.index_buffer.id());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(*first_index * sizeof(uint32_t)), static_cast<GLsizeiptr>(indices.size_bytes()), indices.data());
+        return SharedMesh{*this, arena_index, *first_vertex, vertices_count, *first_index, indices.size(), internal::compute_position_bounds(vertices, _members, _stride)};
+    }
+}
+
+void MeshPool::remove(SharedMesh const& mesh)
+{
+    auto& arena = _arenas[mesh._arena_index];
+    arena.vertices.free(mesh._first_vertex, mesh._vertices_count);
+    arena.indices.free(mesh._first_index, mesh._indices_count);
+}
+
+void MeshPool::bind_arena(size_t arena_index) const
+{
+    glBindVertexArray(_arenas[arena_index].vertex_array.id());
+}
+
+void SharedMesh::draw() const
+{
+    _pool->bind_arena(_arena_index);
+    glDrawElementsBaseVertex(GL_TRIANGLES, indices_count(), GL_UNSIGNED_INT, reinterpret_cast<void*>(_first_index * sizeof(uint32_t)), base_vertex()); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+}
+
+void SharedMesh::draw_instanced(GLsizei instances_count, GLuint base_instance) const
+{
+    _pool->bind_arena(_arena_index);
+    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, indices_count(), GL_UNSIGNED_INT, reinterpret_cast<void*>(_first_index * sizeof(uint32_t)), instances_count, base_vertex(), base_instance); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+}
+
+SharedMesh::~SharedMesh()
+{
+    if (_pool != nullptr) // Might have been moved-from
+        _pool->remove(*this);
+}
+
+SharedMesh::SharedMesh(SharedMesh&& o) noexcept
+    : _pool{o._pool}
+    , _arena_index{o._arena_index}
+    , _first_vertex{o._first_vertex}
+    , _vertices_count{o._vertices_count}
+    , _first_index{o._first_index}
+    , _indices_count{o._indices_count}
+    , _bounds{o._bounds}
+{
+    o._pool = nullptr;
+}
+
+auto SharedMesh::operator=(SharedMesh&& o) noexcept -> SharedMesh&
+{
+    if (this != &o)
+    {
+        if (_pool != nullptr)
+            _pool->remove(*this);
+        _pool           = o._pool;
+        _arena_index    = o._arena_index;
+        _first_vertex   = o._first_vertex;
+        _vertices_count = o._vertices_count;
+        _first_index    = o._first_index;
+        _indices_count  = o._indices_count;
+        _bounds         = o._bounds;
+        o._pool         = nullptr;
+    }
+    return *this;
+}
+
+} // namespace gl
@@ -0,0 +1,185 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "FreeListAllocator.hpp"
+#include "Mesh.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+namespace internal {
+class UniqueBuffer {
+public:
+    UniqueBuffer() // NOLINT(*-member-init)
+    {
+        glGenBuffers(1, &_id);
+    }
+    ~UniqueBuffer()
+    {
+        glDeleteBuffers(1, &_id);
+    }
+    UniqueBuffer(UniqueBuffer const&)                    = delete; // You cannot copy
+    auto operator=(UniqueBuffer const&) -> UniqueBuffer& = delete; // a Buffer. But you can move it, using std::move(my_buffer)
+    UniqueBuffer(UniqueBuffer&& o) noexcept
+        : _id{o._id}
+    {
+        o._id = 0;
+    }
+    auto operator=(UniqueBuffer&& o) noexcept -> UniqueBuffer&
+    {
+        if (&o != this)
+        {
+            glDeleteBuffers(1, &_id);
+            _id   = o._id;
+            o._id = 0;
+        }
+        return *this;
+    }
+
+    auto id() const { return _id; }
+
+private:
+    GLuint _id;
+};
+
+class UniqueVertexArray {
+public:
+    UniqueVertexArray() // NOLINT(*-member-init)
+    {
+        glGenVertexArrays(1, &_id);
+    }
+    ~UniqueVertexArray()
+    {
+        glDeleteVertexArrays(1, &_id);
+    }
+    UniqueVertexArray(UniqueVertexArray const&)                    = delete; // You cannot copy
+    auto operator=(UniqueVertexArray const&) -> UniqueVertexArray& = delete; // a VertexArray. But you can move it, using std::move(my_vertex_array)
+    UniqueVertexArray(UniqueVertexArray&& o) noexcept
+        : _id{o._id}
+    {
+        o._id = 0;
+    }
+    auto operator=(UniqueVertexArray&& o) noexcept -> UniqueVertexArray&
+    {
+        if (&o != this)
+        {
+            glDeleteVertexArrays(1, &_id);
+            _id   = o._id;
+            o._id = 0;
+        }
+        return *this;
+    }
+
+    auto id() const { return _id; }
+
+private:
+    GLuint _id;
+};
+} // namespace internal
+
+class MeshPool;
+
+/// A mesh whose vertices and indices live in the big buffers of a MeshPool. It is only a range of these buffers, and gives it back to the pool when destroyed.
+/// All the meshes of a pool share the same vertex array, so drawing many of them in a row doesn't require any state change other than the draw call itself.
+class SharedMesh {
+public:
+    ~SharedMesh();
+    SharedMesh(SharedMesh const&)                    = delete; // You cannot copy
+    auto operator=(SharedMesh const&) -> SharedMesh& = delete; // a SharedMesh. But you can move it, using std::move(my_mesh)
+    SharedMesh(SharedMesh&&) noexcept;
+    auto operator=(SharedMesh&&) noexcept -> SharedMesh&;
+
+    void draw() const;
+    /// See Mesh::draw_instanced(). Requires OpenGL 4.2, even when base_instance is 0.
+    void draw_instanced(GLsizei instances_count, GLuint base_instance = 0) const;
+
+    auto pool() const -> MeshPool& { return *_pool; }
+    /// Index of the buffers that store this mesh, in its pool
+    auto arena_index() const -> size_t { return _arena_index; }
+    /// Position of the first index of the mesh in the index buffer (not in bytes)
+    auto first_index() const -> GLuint { return static_cast<GLuint>(_first_index); }
+    auto indices_count() const -> GLsizei { return static_cast<GLsizei>(_indices_count); }
+    /// Added to each index, since the indices are relative to the first vertex of the mesh
+    auto base_vertex() const -> GLint { return static_cast<GLint>(_first_vertex); }
+    /// See Mesh::bounds()
+    auto bounds() const -> std::optional<Bounds> const& { return _bounds; }
+
+private:
+    friend class MeshPool;
+    SharedMesh(MeshPool& pool, size_t arena_index, size_t first_vertex, size_t vertices_count, size_t first_index, size_t indices_count, std::optional<Bounds> const& bounds)
+        : _pool{&pool}
+        , _arena_index{arena_index}
+        , _first_vertex{first_vertex}
+        , _vertices_count{vertices_count}
+        , _first_index{first_index}
+        , _indices_count{indices_count}
+        , _bounds{bounds}
+    {}
+
+private:
+    MeshPool*             _pool; /// nullptr when moved-from
+    size_t                _arena_index;
+    size_t                _first_vertex;
+    size_t                _vertices_count;
+    size_t                _first_index;
+    size_t                _indices_count;
+    std::optional<Bounds> _bounds;
+};
+
+struct MeshPool_Descriptor {
+    std::vector<AnyVertexAttribute> const& layout;                            // NOLINT(*avoid-const-or-ref-data-members)
+    size_t                                 first_arena_vertices_count{size_t{1} << 14}; /// Capacity of the first vertex buffer. When all the arenas are full, a new one is created, twice as big as the previous one.
+    size_t                                 first_arena_indices_count{size_t{3} << 14};  /// Capacity of the first index buffer, it grows like the vertex buffers
+    size_t                                 max_arena_vertices_count{size_t{1} << 20};   /// The arenas stop growing once they reach this size (unless a single mesh needs more)
+    size_t                                 max_arena_indices_count{size_t{3} << 20};
+};
+
+/// Stores many meshes with the same vertex layout in a few big vertex and index buffers ("arenas"), instead of giving each mesh its own buffers and vertex array.
+/// Indices are always 32-bit, so that all the meshes of an arena can be drawn with the same index type.
+class MeshPool {
+public:
+    explicit MeshPool(MeshPool_Descriptor const&);
+    ~MeshPool()                                  = default;
+    MeshPool(MeshPool const&)                    = delete; // You cannot copy
+    auto operator=(MeshPool const&) -> MeshPool& = delete; // a MeshPool, nor move it, because the SharedMeshes point to it
+    MeshPool(MeshPool&&)                         = delete;
+    auto operator=(MeshPool&&) -> MeshPool&      = delete;
+
+    /// The pool used by all the meshes that have this layout. It is created the first time you ask for it.
+    static auto shared(std::vector<AnyVertexAttribute> const& layout) -> MeshPool&;
+
+    /// `vertices` must be laid out as described by the layout of the pool, and `indices` are relative to the first of these vertices.
+    auto add(std::span<std::byte const> vertices, std::span<uint32_t const> indices) -> SharedMesh;
+
+    /// Binds the vertex array of the given arena. The index buffer is bound with it.
+    void bind_arena(size_t arena_index) const;
+    auto arenas_count() const -> size_t { return _arenas.size(); }
+    auto members() const -> std::span<VertexMember const> { return _members; }
+    auto stride() const -> GLsizei { return _stride; }
+
+private:
+    friend class SharedMesh;
+    void remove(SharedMesh const&);
+    auto add_arena(size_t min_vertices_count, size_t min_indices_count) -> size_t;
+
+private:
+    struct Arena {
+        internal::UniqueVertexArray vertex_array{};
+        internal::UniqueBuffer      vertex_buffer{};
+        internal::UniqueBuffer      index_buffer{};
+        internal::FreeListAllocator vertices; /// In vertices, not in bytes
+        internal::FreeListAllocator indices;  /// In indices, not in bytes
+    };
+    std::vector<Arena>        _arenas{};
+    std::vector<VertexMember> _members;
+    GLsizei                   _stride;
+    size_t                    _next_arena_vertices_count;
+    size_t                    _next_arena_indices_count;
+    size_t                    _max_arena_vertices_count;
+    size_t                    _max_arena_indices_count;
+};
+
+} // namespace gl
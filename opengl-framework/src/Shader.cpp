@@ -1,7 +1,10 @@
 #include "Shader.hpp"
 #include <cassert>
 #include <fstream>
+#include <vector>
 #include "Texture.hpp"
+#include "TextureSamplerLibrary.hpp"
+#include "TextureUnits.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "handle_error.hpp"
 #include "make_absolute_path.hpp"
@@ -201,41 +204,16 @@ void Shader::set_uniform(std::string_view uniform_name, const glm::mat4& mat) co
     glUniformMatrix4fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-static auto max_number_of_texture_slots() -> GLuint
+void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const
 {
-    GLint res{};
-    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &res);
-    return static_cast<GLuint>(res);
+    auto const unit = internal::bind_texture_to_unit(GL_TEXTURE_2D, texture.id(), TextureSamplerLibrary::instance().get(texture.options()));
+    set_uniform(uniform_name, unit);
 }
 
-static auto get_next_texture_slot() -> GLuint
+void Shader::set_uniform(std::string_view uniform_name, TextureArray const& texture) const
 {
-    static GLuint       current_slot = 0;
-    static GLuint const max_slots    = max_number_of_texture_slots();
-
-    current_slot = (current_slot + 1) % max_slots;
-    if (current_slot == 0) // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
-        current_slot = 1;
-    return current_slot;
+    auto const unit = internal::bind_texture_to_unit(GL_TEXTURE_2D_ARRAY, texture.id(), TextureSamplerLibrary::instance().get(texture.options()));
+    set_uniform(uniform_name, unit);
 }
 
-void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const
-{
-    auto const slot = get_next_texture_slot();
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, texture.id());
-    set_uniform(uniform_name, slot);
-    glActiveTexture(GL_TEXTURE0); // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
-}
-
-// void Shader::set_uniform_texture(std::string_view uniform_name, GLuint texture_id, TextureSamplerDescriptor const& sampler) const
-// {
-//     auto const slot = get_next_texture_slot();
-//     glActiveTexture(GL_TEXTURE0 + slot);
-//     glBindTexture(GL_TEXTURE_2D, texture_id);
-//     glBindSampler(slot, TextureSamplerLibrary::instance().get(sampler).id()));
-//     set_uniform(uniform_name, static_cast<int>(slot));
-//     glActiveTexture(GL_TEXTURE0); // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
-// }
-
 } // namespace gl
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <variant>
 #include "Texture.hpp"
+#include "TextureArray.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 
@@ -84,6 +85,7 @@ public:
     void set_uniform(std::string_view uniform_name, glm::mat3 const&) const;
     void set_uniform(std::string_view uniform_name, glm::mat4 const&) const;
     void set_uniform(std::string_view uniform_name, Texture const&) const;
+    void set_uniform(std::string_view uniform_name, TextureArray const&) const;
 
 private:
     auto uniform_location(std::string_view uniform_name) const -> GLint;
@@ -1,5 +1,7 @@
 #include "Texture.hpp"
+#include <algorithm>
 #include <cassert>
+#include "CompressedTexture.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "img/img.hpp"
 #include "make_absolute_path.hpp"
@@ -22,7 +24,19 @@ static void upload_image_data(TextureSource::File const& source)
     upload_image_data(TextureSource::Pixels{.pixels = image.data_span(), .width = static_cast<GLsizei>(image.width()), .height = static_cast<GLsizei>(image.height()), .source_pixels_type = Type::UnsignedByte, .source_pixels_format = Format::RGBA, .texture_format = source.texture_format});
 }
 
+static void upload_image_data(TextureSource::CompressedFile const& source)
+{
+    auto const image  = load_ktx2(make_absolute_path(source.path));
+    auto const format = gl_internal_format(image.format);
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), format, std::max(image.width >> level, 1), std::max(image.height >> level, 1), 0, static_cast<GLsizei>(image.levels[level].size()), image.levels[level].data());
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+}
+
 Texture::Texture(AnyTextureSource const& source, TextureOptions const& options)
+    : _options{options}
 {
     glBindTexture(GL_TEXTURE_2D, _id.id());
     std::visit([&](auto&& source) { upload_image_data(source); }, source);
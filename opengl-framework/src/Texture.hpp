@@ -3,6 +3,7 @@
 #include <span>
 #include <variant>
 #include "glad/gl.h"
+#include "TextureUnits.hpp"
 #include "glm/glm.hpp"
 
 namespace gl {
@@ -307,6 +308,7 @@ public:
     }
     ~UniqueTexture()
     {
+        forget_texture(_id);
         glDeleteTextures(1, &_id);
     }
     UniqueTexture(UniqueTexture const&)                    = delete; // You cannot copy
@@ -320,6 +322,7 @@ public:
     {
         if (&o != this)
         {
+            forget_texture(_id);
             glDeleteTextures(1, &_id);
             _id   = o._id;
             o._id = 0;
@@ -348,6 +351,11 @@ struct Pixels {
     Format                   source_pixels_format{Format::RGBA};
     InternalFormat           texture_format{InternalFormat::RGBA};
 };
+/// A .ktx2 file containing a block-compressed image and all its mipmaps (see CompressedTexture.hpp to create such files).
+/// Compressed textures use 4 to 8 times less VRAM, and are faster to load than PNGs.
+struct CompressedFile {
+    std::filesystem::path path{};
+};
 struct EmptyImage {
     GLsizei             width{};
     GLsizei             height{};
@@ -358,6 +366,7 @@ struct EmptyImage {
 using AnyTextureSource = std::variant<
     TextureSource::File,
     TextureSource::Pixels,
+    TextureSource::CompressedFile,
     TextureSource::EmptyImage>;
 
 struct TextureOptions {
@@ -366,6 +375,8 @@ struct TextureOptions {
     Wrap      wrap_x{Wrap::ClampToEdge};
     Wrap      wrap_y{Wrap::ClampToEdge};
     glm::vec4 border_color{0.f}; // Only used when at least one of the Wrap is set to ClampToBorder
+
+    friend auto operator==(TextureOptions const&, TextureOptions const&) -> bool = default;
 };
 
 class Texture {
@@ -373,9 +384,11 @@ public:
     explicit Texture(AnyTextureSource const&, TextureOptions const& = {});
 
     auto id() const -> GLuint { return _id.id(); }
+    auto options() const -> TextureOptions const& { return _options; }
 
 private:
     internal::UniqueTexture _id{};
+    TextureOptions          _options{};
 };
 
 } // namespace gl
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "TextureArray.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "glm/gtc/type_ptr.hpp"
+#include "img/img.hpp"
+#include "make_absolute_path.hpp"
+
+namespace gl {
+
+TextureArray::TextureArray(TextureArray_Descriptor const& desc, TextureOptions const& options)
+    : _options{options}
+{
+    assert(!desc.images.empty() && "You must provide at least one image to create a TextureArray.");
+
+    auto images = std::vector<img::Image>{};
+    images.reserve(desc.images.size());
+    auto size = glm::ivec2{1};
+    for (auto const& path : desc.images)
+    {
+        auto const& image = images.emplace_back(img::load(make_absolute_path(path), 4, desc.flip_y));
+        size              = glm::max(size, glm::ivec2{image.width(), image.height()});
+    }
+
+    auto const generate_mipmaps = options.minification_filter == Filter::LinearMipmapLinear;
+    auto const levels_count     = generate_mipmaps ? 1 + static_cast<GLsizei>(std::floor(std::log2(std::max(size.x, size.y)))) : 1;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, _id.id());
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels_count, static_cast<GLenum>(desc.texture_format), size.x, size.y, static_cast<GLsizei>(images.size()));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t layer = 0; layer < images.size(); ++layer)
+    {
+        auto const& image = images[layer];
+        auto const  w     = static_cast<GLsizei>(image.width());
+        auto const  h     = static_cast<GLsizei>(image.height());
+        if (w == size.x && h == size.y)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+        }
+        else
+        {
+            // glTexStorage3D() leaves the texels undefined, and bilinear filtering and mipmaps would blend them into the image.
+            // So fill the whole layer, by repeating the border of the image.
+            auto padded = std::vector<uint8_t>(static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4);
+            for (GLsizei y = 0; y < size.y; ++y)
+            {
+                for (GLsizei x = 0; x < size.x; ++x)
+                {
+                    auto const src = glm::min(glm::ivec2{x, y}, glm::ivec2{w, h} - 1);
+                    std::copy_n(image.data() + static_cast<size_t>(src.x + src.y * w) * 4, 4, padded.data() + static_cast<size_t>(x + y * size.x) * 4);
+                }
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), size.x, size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+        }
+        _layers_uv_scale.emplace_back(static_cast<float>(w) / static_cast<float>(size.x), static_cast<float>(h) / static_cast<float>(size.y));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (generate_mipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(options.minification_filter));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(options.magnification_filter));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, static_cast<GLint>(options.wrap_x));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, static_cast<GLint>(options.wrap_y));
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(options.border_color));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+} // namespace gl
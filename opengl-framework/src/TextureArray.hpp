@@ -0,0 +1,36 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+#include "Texture.hpp"
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+struct TextureArray_Descriptor {
+    std::vector<std::filesystem::path> images{};
+    bool                               flip_y{true}; /// There is often conflicting conventions between image files and OpenGL, they don't put the Y axis in the same direction. You can use this boolean to flip your images in the right direction.
+    InternalFormatSized                texture_format{InternalFormatSized::RGBA8};
+};
+
+/// A GL_TEXTURE_2D_ARRAY with one layer per image. In GLSL, use a `sampler2DArray` and sample it with `texture(u_sprites, vec3(uv, layer))`.
+/// All the layers have the size of the biggest image. Smaller images are stored in the bottom-left corner of their layer: multiply your UVs by layer_uv_scale() to only sample the image. The rest of the layer repeats the border of the image, so that filtering and mipmaps don't bleed garbage into it.
+/// This allows all the particles to be drawn in a single draw call, even if they use different sprites.
+class TextureArray {
+public:
+    explicit TextureArray(TextureArray_Descriptor const&, TextureOptions const& = {});
+
+    auto id() const -> GLuint { return _id.id(); }
+    auto options() const -> TextureOptions const& { return _options; }
+    auto layers_count() const -> GLsizei { return static_cast<GLsizei>(_layers_uv_scale.size()); }
+    /// The UV lookup table: for each layer, the part of the layer that is covered by its image.
+    auto layers_uv_scale() const -> std::vector<glm::vec2> const& { return _layers_uv_scale; }
+    auto layer_uv_scale(size_t layer) const -> glm::vec2 { return _layers_uv_scale.at(layer); }
+
+private:
+    internal::UniqueTexture _id{};
+    TextureOptions          _options{};
+    std::vector<glm::vec2>  _layers_uv_scale{};
+};
+
+} // namespace gl
@@ -0,0 +1,290 @@
+#include "TextureAtlas.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include "handle_error.hpp"
+#include "img/img.hpp"
+#include "make_absolute_path.hpp"
+
+namespace gl {
+
+namespace {
+
+struct SkylineNode {
+    int x{};
+    int y{};
+    int width{};
+};
+
+/// Returns the height at which a rectangle of the given size can be placed, starting at the given skyline node, or std::nullopt if it doesn't fit.
+auto fit(std::vector<SkylineNode> const& skyline, size_t node_index, glm::ivec2 size, glm::ivec2 atlas_size) -> std::optional<int>
+{
+    int const x = skyline[node_index].x;
+    if (x + size.x > atlas_size.x)
+        return std::nullopt;
+
+    int y          = skyline[node_index].y;
+    int width_left = size.x;
+    for (size_t i = node_index; width_left > 0; ++i)
+    {
+        y = std::max(y, skyline[i].y);
+        if (y + size.y > atlas_size.y)
+            return std::nullopt;
+        width_left -= skyline[i].width;
+    }
+    return y;
+}
+
+void add_node(std::vector<SkylineNode>& skyline, size_t node_index, glm::ivec2 position, glm::ivec2 size)
+{
+    skyline.insert(skyline.begin() + static_cast<std::ptrdiff_t>(node_index), SkylineNode{.x = position.x, .y = position.y + size.y, .width = size.x});
+
+    // Shrink the nodes that are now (partially) covered by the new one
+    for (size_t i = node_index + 1; i < skyline.size();)
+    {
+        auto const& previous = skyline[i - 1];
+        auto&       node     = skyline[i];
+        int const   overlap  = previous.x + previous.width - node.x;
+        if (overlap <= 0)
+            break;
+        node.x += overlap;
+        node.width -= overlap;
+        if (node.width > 0)
+            break;
+        skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+
+    // Merge neighbours that are at the same height
+    for (size_t i = 0; i + 1 < skyline.size();)
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i + 1));
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+auto try_pack(std::span<glm::ivec2 const> sizes, std::span<size_t const> order, glm::ivec2 atlas_size) -> std::optional<std::vector<glm::ivec2>>
+{
+    auto positions = std::vector<glm::ivec2>(sizes.size());
+    auto skyline   = std::vector<SkylineNode>{{.x = 0, .y = 0, .width = atlas_size.x}};
+    for (size_t const rect : order)
+    {
+        auto const size = sizes[rect];
+
+        // Bottom-left heuristic: lowest top edge, then narrowest node
+        auto best_node  = std::optional<size_t>{};
+        int  best_top   = INT_MAX;
+        int  best_width = INT_MAX;
+        for (size_t i = 0; i < skyline.size(); ++i)
+        {
+            auto const y = fit(skyline, i, size, atlas_size);
+            if (!y)
+                continue;
+            if (*y + size.y < best_top || (*y + size.y == best_top && skyline[i].width < best_width))
+            {
+                best_node  = i;
+                best_top   = *y + size.y;
+                best_width = skyline[i].width;
+            }
+        }
+        if (!best_node)
+            return std::nullopt;
+
+        positions[rect] = {skyline[*best_node].x, best_top - size.y};
+        add_node(skyline, *best_node, positions[rect], size);
+    }
+    return positions;
+}
+
+struct AtlasImage {
+    glm::ivec2               size{};
+    std::vector<uint8_t>     pixels{};
+    std::vector<AtlasRegion> regions{};
+};
+
+auto build_atlas_image(TextureAtlas_Descriptor const& desc) -> AtlasImage
+{
+    auto images = std::vector<img::Image>{};
+    auto sizes  = std::vector<glm::ivec2>{};
+    for (auto const& path : desc.images)
+    {
+        auto const& image = images.emplace_back(img::load(make_absolute_path(path), 4, desc.flip_y));
+        sizes.emplace_back(glm::ivec2{image.width(), image.height()} + 2 * desc.padding);
+    }
+
+    auto const packing = pack_rectangles(sizes, desc.max_size);
+    if (!packing)
+        handle_error(std::format("[TextureAtlas] The {} images don't fit in a {}x{} atlas.", desc.images.size(), desc.max_size, desc.max_size));
+
+    auto res = AtlasImage{.size = packing->size, .pixels = std::vector<uint8_t>(static_cast<size_t>(packing->size.x * packing->size.y) * 4)};
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        auto const& image      = images[i];
+        auto const  image_size = glm::ivec2{image.width(), image.height()};
+        auto const  position   = packing->positions[i];
+        // Copy the image, and repeat its border in the padding area
+        for (int y = 0; y < sizes[i].y; ++y)
+        {
+            for (int x = 0; x < sizes[i].x; ++x)
+            {
+                auto const src = glm::clamp(glm::ivec2{x, y} - desc.padding, glm::ivec2{0}, image_size - 1);
+                auto const dst = position + glm::ivec2{x, y};
+                std::copy_n(image.data() + static_cast<size_t>(src.x + src.y * image_size.x) * 4, 4, res.pixels.data() + static_cast<size_t>(dst.x + dst.y * res.size.x) * 4);
+            }
+        }
+        res.regions.push_back({
+            .uv_min = glm::vec2{position + desc.padding} / glm::vec2{res.size},
+            .uv_max = glm::vec2{position + desc.padding + image_size} / glm::vec2{res.size},
+        });
+    }
+    return res;
+}
+
+// ---Cache---
+
+constexpr auto cache_magic = std::array<char, 8>{'G', 'L', 'A', 'T', 'L', 'A', 'S', '1'};
+
+/// Everything that must not have changed for the cache to be valid
+auto cache_key(TextureAtlas_Descriptor const& desc) -> std::vector<char>
+{
+    auto       key   = std::vector<char>{};
+    auto const write = [&](auto const& value) {
+        auto const* bytes = reinterpret_cast<char const*>(&value); // NOLINT(*reinterpret-cast)
+        key.insert(key.end(), bytes, bytes + sizeof(value));
+    };
+    write(desc.padding);
+    write(desc.flip_y);
+    write(desc.images.size());
+    for (auto const& path : desc.images)
+    {
+        auto const absolute_path = make_absolute_path(path).string();
+        write(absolute_path.size());
+        key.insert(key.end(), absolute_path.begin(), absolute_path.end());
+        write(std::filesystem::file_size(absolute_path));
+        write(std::filesystem::last_write_time(absolute_path).time_since_epoch().count());
+    }
+    return key;
+}
+
+auto load_cache(std::filesystem::path const& path, std::vector<char> const& key, size_t regions_count) -> std::optional<AtlasImage>
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file)
+        return std::nullopt;
+
+    auto const read = [&](void* dst, size_t size) {
+        file.read(static_cast<char*>(dst), static_cast<std::streamsize>(size));
+        return static_cast<bool>(file);
+    };
+    auto magic = std::array<char, 8>{};
+    if (!read(magic.data(), magic.size()) || magic != cache_magic)
+        return std::nullopt;
+    auto file_key = std::vector<char>(key.size());
+    if (!read(file_key.data(), file_key.size()) || file_key != key)
+        return std::nullopt; // One of the images has changed
+
+    auto res = AtlasImage{};
+    if (!read(&res.size, sizeof(res.size)) || res.size.x <= 0 || res.size.y <= 0)
+        return std::nullopt;
+    res.regions.resize(regions_count);
+    res.pixels.resize(static_cast<size_t>(res.size.x * res.size.y) * 4);
+    if (!read(res.regions.data(), res.regions.size() * sizeof(AtlasRegion)) || !read(res.pixels.data(), res.pixels.size()))
+        return std::nullopt;
+    return res;
+}
+
+void save_cache(std::filesystem::path const& path, std::vector<char> const& key, AtlasImage const& atlas)
+{
+    auto file = std::ofstream{path, std::ios::binary};
+    file.write(cache_magic.data(), cache_magic.size());
+    file.write(key.data(), static_cast<std::streamsize>(key.size()));
+    file.write(reinterpret_cast<char const*>(&atlas.size), sizeof(atlas.size));                                                          // NOLINT(*reinterpret-cast)
+    file.write(reinterpret_cast<char const*>(atlas.regions.data()), static_cast<std::streamsize>(atlas.regions.size() * sizeof(AtlasRegion))); // NOLINT(*reinterpret-cast)
+    file.write(reinterpret_cast<char const*>(atlas.pixels.data()), static_cast<std::streamsize>(atlas.pixels.size()));                       // NOLINT(*reinterpret-cast)
+    if (!file)
+        std::cerr << "[TextureAtlas] Failed to write the cache file \"" << path.string() << "\"\n";
+}
+
+auto make_atlas(TextureAtlas_Descriptor const& desc, TextureOptions const& options) -> std::pair<Texture, std::vector<AtlasRegion>>
+{
+    auto atlas = std::optional<AtlasImage>{};
+    auto key   = std::vector<char>{};
+    if (desc.cache_path)
+    {
+        key   = cache_key(desc);
+        atlas = load_cache(*desc.cache_path, key, desc.images.size());
+    }
+    if (!atlas)
+    {
+        atlas = build_atlas_image(desc);
+        if (desc.cache_path)
+            save_cache(*desc.cache_path, key, *atlas);
+    }
+
+    return {
+        Texture{
+            TextureSource::Pixels{
+                .pixels         = atlas->pixels,
+                .width          = atlas->size.x,
+                .height         = atlas->size.y,
+                .texture_format = InternalFormat::RGBA8,
+            },
+            options
+        },
+        std::move(atlas->regions),
+    };
+}
+
+} // namespace
+
+auto pack_rectangles(std::span<glm::ivec2 const> sizes, GLsizei max_size) -> std::optional<AtlasPacking>
+{
+    // Place the tallest rectangles first, it gives much tighter packings
+    auto order = std::vector<size_t>(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sizes[a].y != sizes[b].y ? sizes[a].y > sizes[b].y : sizes[a].x > sizes[b].x;
+    });
+
+    // Start with the smallest power of two that could hold the total area, and grow until everything fits
+    int64_t area     = 0;
+    int     max_side = 1;
+    for (auto const& size : sizes)
+    {
+        area += int64_t{size.x} * size.y;
+        max_side = std::max({max_side, size.x, size.y});
+    }
+    auto atlas_size = glm::ivec2{static_cast<int>(std::bit_ceil(static_cast<uint32_t>(max_side)))};
+    while (int64_t{atlas_size.x} * atlas_size.y < area)
+        (atlas_size.x <= atlas_size.y ? atlas_size.x : atlas_size.y) *= 2;
+
+    while (atlas_size.x <= max_size && atlas_size.y <= max_size)
+    {
+        if (auto positions = try_pack(sizes, order, atlas_size))
+            return AtlasPacking{.size = atlas_size, .positions = std::move(*positions)};
+        (atlas_size.x <= atlas_size.y ? atlas_size.x : atlas_size.y) *= 2;
+    }
+    return std::nullopt;
+}
+
+TextureAtlas::TextureAtlas(TextureAtlas_Descriptor const& desc, TextureOptions const& options)
+    : TextureAtlas{make_atlas(desc, options)}
+{}
+
+TextureAtlas::TextureAtlas(std::pair<Texture, std::vector<AtlasRegion>>&& atlas)
+    : _texture{std::move(atlas.first)}
+    , _regions{std::move(atlas.second)}
+{}
+
+} // namespace gl
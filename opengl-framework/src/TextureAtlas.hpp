@@ -0,0 +1,52 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+#include "Texture.hpp"
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+struct AtlasPacking {
+    glm::ivec2              size{};      /// Size of the atlas, in pixels
+    std::vector<glm::ivec2> positions{}; /// Bottom-left corner of each rectangle, in the same order as the input sizes
+};
+
+/// Packs the rectangles into the smallest power-of-two square-ish atlas that can hold them, using the skyline bottom-left heuristic.
+/// Returns std::nullopt if they don't fit in a max_size x max_size atlas.
+auto pack_rectangles(std::span<glm::ivec2 const> sizes, GLsizei max_size = 8192) -> std::optional<AtlasPacking>;
+
+struct AtlasRegion {
+    glm::vec2 uv_min{};
+    glm::vec2 uv_max{};
+};
+
+struct TextureAtlas_Descriptor {
+    std::vector<std::filesystem::path>   images{};
+    bool                                 flip_y{true}; /// There is often conflicting conventions between image files and OpenGL, they don't put the Y axis in the same direction. You can use this boolean to flip your images in the right direction.
+    GLsizei                              padding{1};   /// Number of pixels around each image where its border gets repeated, so that linear filtering doesn't bleed between neighbouring images.
+    GLsizei                              max_size{8192};
+    std::optional<std::filesystem::path> cache_path{}; /// If set, the packed atlas is saved to this file, and loaded from it on the next launches as long as none of the images has changed.
+};
+
+/// Many small images packed into a single texture, so that particles using different sprites can be drawn with a single draw call.
+class TextureAtlas {
+public:
+    explicit TextureAtlas(TextureAtlas_Descriptor const&, TextureOptions const& = {});
+
+    auto texture() const -> Texture const& { return _texture; }
+    /// The UV lookup table: where each image is in the atlas, in the same order as TextureAtlas_Descriptor::images.
+    auto regions() const -> std::vector<AtlasRegion> const& { return _regions; }
+    auto region(size_t image_index) const -> AtlasRegion const& { return _regions.at(image_index); }
+
+private:
+    TextureAtlas(std::pair<Texture, std::vector<AtlasRegion>>&&);
+
+private:
+    Texture                  _texture;
+    std::vector<AtlasRegion> _regions{};
+};
+
+} // namespace gl
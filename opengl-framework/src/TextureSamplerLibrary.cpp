@@ -0,0 +1,45 @@
+#include "TextureSamplerLibrary.hpp"
+#include <functional>
+#include "glm/gtc/type_ptr.hpp"
+
+namespace gl {
+
+namespace internal {
+auto TextureOptionsHash::operator()(TextureOptions const& options) const -> size_t
+{
+    size_t     res     = 0;
+    auto const combine = [&](auto const& value) {
+        res ^= std::hash<std::decay_t<decltype(value)>>{}(value) + 0x9e3779b9 + (res << 6) + (res >> 2);
+    };
+    combine(static_cast<GLint>(options.minification_filter));
+    combine(static_cast<GLint>(options.magnification_filter));
+    combine(static_cast<GLint>(options.wrap_x));
+    combine(static_cast<GLint>(options.wrap_y));
+    for (glm::length_t i = 0; i < 4; ++i)
+        combine(options.border_color[i]);
+    return res;
+}
+} // namespace internal
+
+auto TextureSamplerLibrary::instance() -> TextureSamplerLibrary&
+{
+    static auto instance = TextureSamplerLibrary{};
+    return instance;
+}
+
+auto TextureSamplerLibrary::get(TextureOptions const& options) -> GLuint
+{
+    auto const it = _samplers.find(options);
+    if (it != _samplers.end())
+        return it->second.id();
+
+    auto sampler = internal::UniqueSampler{};
+    glSamplerParameteri(sampler.id(), GL_TEXTURE_MIN_FILTER, static_cast<GLint>(options.minification_filter));
+    glSamplerParameteri(sampler.id(), GL_TEXTURE_MAG_FILTER, static_cast<GLint>(options.magnification_filter));
+    glSamplerParameteri(sampler.id(), GL_TEXTURE_WRAP_S, static_cast<GLint>(options.wrap_x));
+    glSamplerParameteri(sampler.id(), GL_TEXTURE_WRAP_T, static_cast<GLint>(options.wrap_y));
+    glSamplerParameterfv(sampler.id(), GL_TEXTURE_BORDER_COLOR, glm::value_ptr(options.border_color));
+    return _samplers.emplace(options, std::move(sampler)).first->second.id();
+}
+
+} // namespace gl
@@ -0,0 +1,60 @@
+#pragma once
+#include <unordered_map>
+#include "Texture.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+namespace internal {
+class UniqueSampler {
+public:
+    UniqueSampler() // NOLINT(*-member-init)
+    {
+        glGenSamplers(1, &_id);
+    }
+    ~UniqueSampler()
+    {
+        glDeleteSamplers(1, &_id);
+    }
+    UniqueSampler(UniqueSampler const&)                    = delete; // You cannot copy
+    auto operator=(UniqueSampler const&) -> UniqueSampler& = delete; // a Sampler. But you can move it, using std::move(my_sampler)
+    UniqueSampler(UniqueSampler&& o) noexcept
+        : _id{o._id}
+    {
+        o._id = 0;
+    }
+    auto operator=(UniqueSampler&& o) noexcept -> UniqueSampler&
+    {
+        if (&o != this)
+        {
+            glDeleteSamplers(1, &_id);
+            _id   = o._id;
+            o._id = 0;
+        }
+        return *this;
+    }
+
+    auto id() const { return _id; }
+
+private:
+    GLuint _id;
+};
+
+struct TextureOptionsHash {
+    auto operator()(TextureOptions const&) const -> size_t;
+};
+} // namespace internal
+
+/// Creates one sampler object per distinct TextureOptions, and shares it between all the textures that use these options.
+class TextureSamplerLibrary {
+public:
+    static auto instance() -> TextureSamplerLibrary&;
+
+    /// Returns the id of a sampler object configured with the given options. It is created the first time these options are requested.
+    auto get(TextureOptions const&) -> GLuint;
+
+private:
+    std::unordered_map<TextureOptions, internal::UniqueSampler, internal::TextureOptionsHash> _samplers{};
+};
+
+} // namespace gl
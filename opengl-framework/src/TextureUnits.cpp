@@ -0,0 +1,90 @@
+#include "TextureUnits.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace gl::internal {
+
+namespace {
+
+struct TextureUnit {
+    GLenum   target{};
+    GLuint   texture_id{0};
+    GLuint   sampler_id{0};
+    uint64_t last_use{0};
+};
+
+auto max_number_of_texture_units() -> GLuint
+{
+    GLint res{};
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &res);
+    return static_cast<GLuint>(res);
+}
+
+struct TextureUnits {
+    std::vector<TextureUnit> units{std::vector<TextureUnit>(max_number_of_texture_units())};
+    uint64_t                 time{0};
+};
+
+auto texture_units() -> TextureUnits&
+{
+    static auto& instance = *new TextureUnits{}; // NOLINT(*owning-memory) Never destroyed, because textures stored in static variables might still call forget_texture() during static destruction
+    return instance;
+}
+
+} // namespace
+
+auto bind_texture_to_unit(GLenum target, GLuint texture_id, GLuint sampler_id) -> GLuint
+{
+    auto& state = texture_units();
+    ++state.time;
+
+    // Look for a unit where the texture is already bound, or else for the least recently used one
+    GLuint best_unit = 1; // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
+    for (GLuint i = 1; i < state.units.size(); ++i)
+    {
+        auto const& unit = state.units[i];
+        if (unit.target == target && unit.texture_id == texture_id)
+        {
+            best_unit = i;
+            break;
+        }
+        if (unit.last_use < state.units[best_unit].last_use)
+            best_unit = i;
+    }
+
+    auto& unit    = state.units[best_unit];
+    unit.last_use = state.time;
+    if (unit.target == target && unit.texture_id == texture_id && unit.sampler_id == sampler_id)
+        return best_unit; // Already bound, nothing to do
+
+    if (unit.target != target || unit.texture_id != texture_id)
+    {
+        glActiveTexture(GL_TEXTURE0 + best_unit);
+        glBindTexture(target, texture_id);
+        glActiveTexture(GL_TEXTURE0);
+        unit.target     = target;
+        unit.texture_id = texture_id;
+    }
+    if (unit.sampler_id != sampler_id)
+    {
+        glBindSampler(best_unit, sampler_id);
+        unit.sampler_id = sampler_id;
+    }
+    return best_unit;
+}
+
+void forget_texture(GLuint texture_id)
+{
+    if (texture_id == 0)
+        return;
+    for (auto& unit : texture_units().units)
+    {
+        if (unit.texture_id == texture_id)
+        {
+            unit.texture_id = 0;
+            unit.last_use   = 0;
+        }
+    }
+}
+
+} // namespace gl::internal
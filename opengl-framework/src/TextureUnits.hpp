@@ -0,0 +1,15 @@
+#pragma once
+#include "glad/gl.h"
+
+namespace gl::internal {
+
+/// Makes sure that the texture is bound to a texture unit with the given sampler, and returns the index of that unit.
+/// If the texture is already bound to a unit we reuse it, so that drawing the same textures frame after frame doesn't issue any glActiveTexture() / glBindTexture() call.
+/// Otherwise the texture replaces the least recently used texture.
+/// Unit 0 is never used, because it is where textures get bound when they are created or modified. And it is always the active unit when this function returns.
+auto bind_texture_to_unit(GLenum target, GLuint texture_id, GLuint sampler_id) -> GLuint;
+
+/// Must be called when a texture is deleted, because OpenGL might reuse its id for a new texture that is not bound yet.
+void forget_texture(GLuint texture_id);
+
+} // namespace gl::internal
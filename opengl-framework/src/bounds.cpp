@@ -0,0 +1,68 @@
+#include "bounds.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace gl {
+
+template<typename GetPosition>
+static auto compute_bounds(size_t count, GetPosition&& get_position) -> Bounds
+{
+    if (count == 0)
+        return {};
+
+    auto box = BoundingBox{.min = get_position(0), .max = get_position(0)};
+    for (size_t i = 1; i < count; ++i)
+    {
+        auto const position = get_position(i);
+        box.min             = glm::min(box.min, position);
+        box.max             = glm::max(box.max, position);
+    }
+
+    // Centering the sphere on the box is not optimal, but it is never much worse than Ritter's algorithm, and much simpler
+    float radius_squared = 0.f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const delta = get_position(i) - box.center();
+        radius_squared   = std::max(radius_squared, glm::dot(delta, delta));
+    }
+    return {.box = box, .sphere = {.center = box.center(), .radius = std::sqrt(radius_squared)}};
+}
+
+auto compute_bounds(std::span<glm::vec3 const> positions) -> Bounds
+{
+    return compute_bounds(positions.size(), [&](size_t i) { return positions[i]; });
+}
+
+auto transform(BoundingBox const& box, glm::mat4 const& model_matrix) -> BoundingBox
+{
+    // Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems, 1990
+    auto const center      = glm::vec3{model_matrix * glm::vec4{box.center(), 1.f}};
+    auto const half_extent = glm::mat3{glm::abs(model_matrix[0]), glm::abs(model_matrix[1]), glm::abs(model_matrix[2])} * box.half_extent();
+    return {.min = center - half_extent, .max = center + half_extent};
+}
+
+auto transform(BoundingSphere const& sphere, glm::mat4 const& model_matrix) -> BoundingSphere
+{
+    float const max_scale = std::sqrt(std::max({
+        glm::dot(glm::vec3{model_matrix[0]}, glm::vec3{model_matrix[0]}),
+        glm::dot(glm::vec3{model_matrix[1]}, glm::vec3{model_matrix[1]}),
+        glm::dot(glm::vec3{model_matrix[2]}, glm::vec3{model_matrix[2]}),
+    }));
+    return {.center = glm::vec3{model_matrix * glm::vec4{sphere.center, 1.f}}, .radius = sphere.radius * max_scale};
+}
+
+namespace internal {
+auto compute_bounds(std::span<std::byte const> vertices, size_t stride, size_t offset, int components_count) -> Bounds
+{
+    assert((components_count == 2 || components_count == 3) && "Positions must be made of 2 or 3 floats");
+    return gl::compute_bounds(vertices.size() / stride, [&](size_t i) {
+        auto position = glm::vec3{0.f};
+        std::memcpy(&position, vertices.data() + i * stride + offset, static_cast<size_t>(components_count) * sizeof(float)); // memcpy because the vertices might not be aligned
+        return position;
+    });
+}
+} // namespace internal
+
+} // namespace gl
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include "glm/glm.hpp"
+
+namespace gl {
+
+/// Axis-aligned bounding box
+struct BoundingBox {
+    glm::vec3 min{0.f};
+    glm::vec3 max{0.f};
+
+    auto center() const -> glm::vec3 { return (min + max) * 0.5f; }
+    auto half_extent() const -> glm::vec3 { return (max - min) * 0.5f; }
+};
+
+struct BoundingSphere {
+    glm::vec3 center{0.f};
+    float     radius{0.f};
+};
+static_assert(sizeof(BoundingSphere) == 4 * sizeof(float), "cull_spheres() loads 4 floats per sphere");
+
+struct Bounds {
+    BoundingBox    box{};
+    BoundingSphere sphere{};
+};
+
+auto compute_bounds(std::span<glm::vec3 const> positions) -> Bounds;
+
+/// The bounds of the transformed object. They are conservative: the box contains the transformed box, and the sphere is scaled by the biggest scale factor of the matrix.
+auto transform(BoundingBox const&, glm::mat4 const& model_matrix) -> BoundingBox;
+auto transform(BoundingSphere const&, glm::mat4 const& model_matrix) -> BoundingSphere;
+
+namespace internal {
+/// Reads the positions directly from interleaved vertices: `components_count` floats (2 or 3) at `offset` bytes from the start of each vertex. 2D positions have z = 0.
+auto compute_bounds(std::span<std::byte const> vertices, size_t stride, size_t offset, int components_count) -> Bounds;
+} // namespace internal
+
+} // namespace gl
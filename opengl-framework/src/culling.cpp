@@ -0,0 +1,105 @@
+#include "culling.hpp"
+#include <algorithm>
+#include <array>
+#include "parallel_for.hpp"
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GL_CULLING_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace gl {
+
+auto is_visible(Frustum const& frustum, BoundingSphere const& sphere) -> bool
+{
+    for (auto const& plane : frustum.planes)
+    {
+        if (glm::dot(glm::vec3{plane}, sphere.center) + plane.w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+auto is_visible(Frustum const& frustum, BoundingBox const& box) -> bool
+{
+    for (auto const& plane : frustum.planes)
+    {
+        // The corner that is the furthest along the normal of the plane
+        auto const corner = glm::mix(box.min, box.max, glm::greaterThanEqual(glm::vec3{plane}, glm::vec3{0.f}));
+        if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0.f)
+            return false;
+    }
+    return true;
+}
+
+/// Appends the visible spheres of [begin, end)
+static void cull_range(Frustum const& frustum, std::span<BoundingSphere const> spheres, size_t begin, size_t end, std::vector<uint32_t>& visible_indices)
+{
+    size_t i = begin;
+#if GL_CULLING_USE_SSE
+    struct SimdPlane {
+        __m128 x, y, z, w;
+    };
+    auto planes = std::array<SimdPlane, 6>{};
+    for (size_t p = 0; p < 6; ++p)
+    {
+        auto const& plane = frustum.planes[p];
+        planes[p]         = {_mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z), _mm_set1_ps(plane.w)};
+    }
+    for (; i + 4 <= end; i += 4)
+    {
+        // Load 4 spheres, and transpose them so that each register contains one coordinate of the 4 spheres
+        auto const* data   = reinterpret_cast<float const*>(spheres.data() + i); // NOLINT(*reinterpret-cast)
+        __m128      x      = _mm_loadu_ps(data + 0);
+        __m128      y      = _mm_loadu_ps(data + 4);
+        __m128      z      = _mm_loadu_ps(data + 8);
+        __m128      radius = _mm_loadu_ps(data + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, radius);
+        __m128 const minus_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 outside = _mm_setzero_ps();
+        for (auto const& plane : planes)
+        {
+            __m128 const distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.x, x), _mm_mul_ps(plane.y, y)), _mm_add_ps(_mm_mul_ps(plane.z, z), plane.w));
+            outside               = _mm_or_ps(outside, _mm_cmplt_ps(distance, minus_radius));
+        }
+        int const outside_mask = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if ((outside_mask & (1 << lane)) == 0)
+                visible_indices.push_back(static_cast<uint32_t>(i) + static_cast<uint32_t>(lane));
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        if (is_visible(frustum, spheres[i]))
+            visible_indices.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+auto cull_spheres(Frustum const& frustum, std::span<BoundingSphere const> spheres, std::vector<uint32_t>& visible_indices, Cull_Options const& options) -> CullingStats
+{
+    size_t const previous_size = visible_indices.size();
+    if (spheres.size() < options.parallel_threshold || threads_count() <= 1)
+    {
+        cull_range(frustum, spheres, 0, spheres.size(), visible_indices);
+    }
+    else
+    {
+        // Each block has its own output, so that the indices stay sorted without any synchronization
+        size_t constexpr block_size     = 4096;
+        size_t const     blocks_count   = (spheres.size() + block_size - 1) / block_size;
+        auto             blocks_visible = std::vector<std::vector<uint32_t>>(blocks_count);
+        parallel_for(blocks_count, 1, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block)
+                cull_range(frustum, spheres, block * block_size, std::min((block + 1) * block_size, spheres.size()), blocks_visible[block]);
+        });
+        for (auto const& block_visible : blocks_visible)
+            visible_indices.insert(visible_indices.end(), block_visible.begin(), block_visible.end());
+    }
+
+    size_t const visible_count = visible_indices.size() - previous_size;
+    return {.visible_count = visible_count, .culled_count = spheres.size() - visible_count};
+}
+
+} // namespace gl
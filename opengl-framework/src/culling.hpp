@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Camera.hpp"
+#include "bounds.hpp"
+
+namespace gl {
+
+/// A sphere or box that touches the frustum, or is inside it, is visible.
+/// The tests are conservative: objects near the corners of the frustum can be considered visible even though they are not, but a visible object is never culled.
+auto is_visible(Frustum const&, BoundingSphere const&) -> bool;
+auto is_visible(Frustum const&, BoundingBox const&) -> bool;
+
+struct CullingStats {
+    size_t visible_count{};
+    size_t culled_count{};
+};
+
+struct Cull_Options {
+    size_t parallel_threshold{16384}; /// Below this number of spheres, everything runs on the calling thread, because starting the other threads would cost more than it saves
+};
+
+/// Tests all the spheres (in world space) against the frustum, 4 at a time with SIMD, and in parallel if there are many of them.
+/// Appends the index of each visible sphere to `visible_indices`, in increasing order.
+auto cull_spheres(Frustum const&, std::span<BoundingSphere const> spheres, std::vector<uint32_t>& visible_indices, Cull_Options const& = {}) -> CullingStats;
+
+} // namespace gl
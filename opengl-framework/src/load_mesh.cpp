@@ -0,0 +1,364 @@
+#include "load_mesh.hpp"
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include "handle_error.hpp"
+#include "MappedFile.hpp"
+#include "make_absolute_path.hpp"
+#include "mesh_cache.hpp"
+#include "optimize_mesh.hpp"
+#include "parallel_for.hpp"
+#include "tiny_obj_loader.h"
+#include "tinyobj_loader_opt.h"
+
+namespace gl {
+
+namespace {
+
+struct VertexKey {
+    int position_index;
+    int normal_index;
+    int uv_index;
+
+    friend auto operator==(VertexKey const&, VertexKey const&) -> bool = default;
+};
+
+struct VertexKeyHash {
+    auto operator()(VertexKey const& key) const -> size_t
+    {
+        // Large odd multipliers spread the bits well enough for our small integers
+        return static_cast<size_t>(key.position_index) * 73856093u
+               ^ static_cast<size_t>(key.normal_index) * 19349663u
+               ^ static_cast<size_t>(key.uv_index) * 83492791u;
+    }
+};
+
+auto mesh_layout() -> std::vector<AnyVertexAttribute>
+{
+    return {VertexAttribute::Position3D{0}, VertexAttribute::Normal3D{1}, VertexAttribute::UV{2}};
+}
+
+/// Interleaves the attributes of each triangle corner, and only stores identical (position, normal, uv) combinations once.
+/// Shared by both .obj parsers, so that they produce exactly the same MeshData.
+class MeshDataBuilder {
+public:
+    MeshDataBuilder(std::span<float const> positions, std::span<float const> normals, std::span<float const> uvs, size_t corners_count)
+        : _positions{positions}
+        , _normals{normals}
+        , _uvs{uvs}
+    {
+        _res.indices.reserve(corners_count);
+        _unique_vertices.reserve(corners_count);
+    }
+
+    void add_corner(int position_index, int normal_index, int uv_index)
+    {
+        if (position_index < 0 || 3 * static_cast<size_t>(position_index) >= _positions.size())
+            handle_error(std::format("[load_mesh] Invalid vertex index {}.", position_index));
+
+        auto const key                 = VertexKey{position_index, normal_index, uv_index};
+        auto const [it, is_new_vertex] = _unique_vertices.try_emplace(key, static_cast<uint32_t>(_unique_vertices.size()));
+        if (is_new_vertex)
+        {
+            append(_positions, position_index, 3);
+            append(_normals, normal_index, 3);
+            append(_uvs, uv_index, 2);
+        }
+        _res.indices.push_back(it->second);
+    }
+
+    auto result() && -> MeshData { return std::move(_res); }
+
+private:
+    /// Missing attributes are set to 0
+    void append(std::span<float const> values, int index, size_t components)
+    {
+        auto const offset = static_cast<size_t>(index) * components;
+        if (index >= 0 && offset + components <= values.size())
+            _res.vertices.insert(_res.vertices.end(), values.begin() + static_cast<std::ptrdiff_t>(offset), values.begin() + static_cast<std::ptrdiff_t>(offset + components));
+        else
+            _res.vertices.insert(_res.vertices.end(), components, 0.f);
+    }
+
+private:
+    std::span<float const>                                   _positions;
+    std::span<float const>                                   _normals;
+    std::span<float const>                                   _uvs;
+    MeshData                                                 _res{.layout = mesh_layout()};
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> _unique_vertices{};
+};
+
+auto parse_classic(std::filesystem::path const& path) -> MeshData
+{
+    auto reader = tinyobj::ObjReader{};
+    auto config = tinyobj::ObjReaderConfig{};
+    config.triangulate  = true;
+    config.vertex_color = false;
+    if (!reader.ParseFromFile(make_absolute_path(path).string(), config))
+        handle_error(std::format("Failed to load \"{}\":\n{}", path.string(), reader.Error()));
+    if (!reader.Warning().empty())
+        std::cerr << std::format("[load_mesh] Warning while loading \"{}\":\n{}", path.string(), reader.Warning()) << '\n';
+
+    auto const& attrib = reader.GetAttrib();
+
+    size_t corners_count = 0;
+    for (auto const& shape : reader.GetShapes())
+        corners_count += shape.mesh.indices.size();
+
+    auto builder = MeshDataBuilder{attrib.vertices, attrib.normals, attrib.texcoords, corners_count};
+    for (auto const& shape : reader.GetShapes())
+    {
+        for (auto const& index : shape.mesh.indices)
+            builder.add_corner(index.vertex_index, index.normal_index, index.texcoord_index);
+    }
+    return std::move(builder).result();
+}
+
+auto parse_multithreaded(std::filesystem::path const& path, unsigned int threads_count) -> MeshData
+{
+    auto const file = internal::MappedFile::open(make_absolute_path(path));
+    if (!file)
+        handle_error(std::format("Failed to load \"{}\": the file doesn't exist or is empty.", path.string()));
+    auto const bytes = file->bytes();
+
+    auto attrib    = tinyobj_opt::attrib_t{};
+    auto shapes    = std::vector<tinyobj_opt::shape_t>{};
+    auto materials = std::vector<tinyobj_opt::material_t>{};
+    auto option    = tinyobj_opt::LoadOption{};
+    option.req_num_threads = static_cast<int>(threads_count == 0 ? gl::threads_count() : threads_count);
+    option.triangulate     = false; // We triangulate ourselves, exactly like the classic parser does
+    if (!tinyobj_opt::parseObj(&attrib, &shapes, &materials, reinterpret_cast<char const*>(bytes.data()), bytes.size(), option)) // NOLINT(*reinterpret-cast)
+        handle_error(std::format("Failed to load \"{}\".", path.string()));
+
+    auto const positions = std::span<float const>{attrib.vertices.data(), attrib.vertices.size()};
+    auto const position  = [&](tinyobj_opt::index_t const& index) {
+        auto const offset = 3 * static_cast<size_t>(index.vertex_index);
+        return offset + 2 < positions.size() ? glm::vec3{positions[offset], positions[offset + 1], positions[offset + 2]} : glm::vec3{0.f};
+    };
+
+    size_t corners_count = 0;
+    for (int const face_size : attrib.face_num_verts)
+        corners_count += face_size >= 3 ? 3 * static_cast<size_t>(face_size - 2) : 0;
+
+    auto builder = MeshDataBuilder{
+        positions,
+        {attrib.normals.data(), attrib.normals.size()},
+        {attrib.texcoords.data(), attrib.texcoords.size()},
+        corners_count,
+    };
+    auto const add_triangle = [&](tinyobj_opt::index_t const& a, tinyobj_opt::index_t const& b, tinyobj_opt::index_t const& c) {
+        for (auto const* index : {&a, &b, &c})
+            builder.add_corner(index->vertex_index, index->normal_index, index->texcoord_index);
+    };
+
+    size_t face_start = 0;
+    for (int const face_size : attrib.face_num_verts)
+    {
+        auto const* face = attrib.indices.data() + face_start;
+        face_start += static_cast<size_t>(face_size);
+        if (face_size == 4)
+        {
+            // Split the quad along its shortest diagonal, like tinyobj::ObjReader does
+            auto const diagonal_02 = position(face[2]) - position(face[0]);
+            auto const diagonal_13 = position(face[3]) - position(face[1]);
+            if (glm::dot(diagonal_02, diagonal_02) < glm::dot(diagonal_13, diagonal_13))
+            {
+                add_triangle(face[0], face[1], face[2]);
+                add_triangle(face[0], face[2], face[3]);
+            }
+            else
+            {
+                add_triangle(face[0], face[1], face[3]);
+                add_triangle(face[1], face[2], face[3]);
+            }
+        }
+        else
+        {
+            // NB: tinyobj::ObjReader uses ear clipping for polygons with more than 4 vertices, so the triangulation of these (rare) faces might differ
+            for (int i = 2; i < face_size; ++i)
+                add_triangle(face[0], face[i - 1], face[i]);
+        }
+    }
+    return std::move(builder).result();
+}
+
+} // namespace
+
+auto MeshData::floats_per_vertex() const -> size_t
+{
+    return static_cast<size_t>(std::accumulate(layout.begin(), layout.end(), 0, [](int acc, AnyVertexAttribute const& attr) {
+        return acc + std::visit([](auto&& attr) { return attr.size(); }, attr);
+    }));
+}
+
+auto PackedVertices::bytes_per_vertex() const -> size_t
+{
+    return std::accumulate(layout.begin(), layout.end(), size_t{0}, [](size_t acc, AnyVertexAttribute const& attr) {
+        return acc + static_cast<size_t>(std::visit([](auto&& attr) { return attr.size_in_bytes(); }, attr));
+    });
+}
+
+auto load_mesh_data(std::filesystem::path const& path, LoadMesh_Options const& options) -> MeshData
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto       res   = options.multithreaded ? parse_multithreaded(path, options.threads_count) : parse_classic(path);
+
+    if (options.log_stats)
+    {
+        auto const duration = std::chrono::duration<float, std::milli>{std::chrono::steady_clock::now() - start};
+        std::cout << std::format("[load_mesh] Loaded \"{}\" in {:.2f} ms: {} vertices ({} before deduplication), {} triangles", path.string(), duration.count(), res.vertices_count(), res.indices.size(), res.indices.size() / 3) << '\n';
+    }
+    if (options.optimize)
+        optimize_mesh(res, {.log_stats = options.log_stats});
+    return res;
+}
+
+auto pack_vertices(MeshData const& data, VertexFormat format) -> PackedVertices
+{
+    if (format == VertexFormat::Float)
+    {
+        auto const bytes = std::as_bytes(std::span{data.vertices});
+        return {.layout = data.layout, .data = {bytes.begin(), bytes.end()}};
+    }
+
+    // Choose the format of each attribute
+    enum class Packing { None, SNorm10_10_10_2, Half2, Half4 };
+    size_t const floats_per_vertex = data.floats_per_vertex();
+    auto         res               = PackedVertices{};
+    auto         packings          = std::vector<Packing>{};
+    size_t       offset            = 0;
+    for (auto const& attribute : data.layout)
+    {
+        auto const [index, size] = std::visit([](auto&& attr) { return std::pair{attr.index(), attr.size()}; }, attribute);
+        auto const is_float      = std::visit([](auto&& attr) { return attr.type() == GL_FLOAT; }, attribute);
+        auto       packing       = Packing::None;
+        if (is_float && index != 0)
+        {
+            if (size == 2)
+                packing = Packing::Half2;
+            else if (size == 4)
+                packing = Packing::Half4;
+            else if (size == 3)
+            {
+                bool is_normalized = true;
+                for (size_t i = offset; i < data.vertices.size() && is_normalized; i += floats_per_vertex)
+                    is_normalized = std::all_of(data.vertices.begin() + static_cast<std::ptrdiff_t>(i), data.vertices.begin() + static_cast<std::ptrdiff_t>(i + 3), [](float x) { return std::abs(x) <= 1.f; });
+                if (is_normalized)
+                    packing = Packing::SNorm10_10_10_2;
+            }
+        }
+        packings.push_back(packing);
+        switch (packing)
+        {
+        case Packing::None:
+            res.layout.push_back(attribute);
+            break;
+        case Packing::SNorm10_10_10_2:
+            res.layout.emplace_back(VertexAttribute::SNorm10_10_10_2{index});
+            break;
+        case Packing::Half2:
+            res.layout.emplace_back(VertexAttribute::Half2{index});
+            break;
+        case Packing::Half4:
+            res.layout.emplace_back(VertexAttribute::Half4{index});
+            break;
+        }
+        offset += static_cast<size_t>(size);
+    }
+
+    // Convert the vertices
+    auto const append = [&](auto const& value) {
+        auto const bytes = std::as_bytes(std::span{&value, 1});
+        res.data.insert(res.data.end(), bytes.begin(), bytes.end());
+    };
+    res.data.reserve(data.vertices_count() * floats_per_vertex * sizeof(float) / 2);
+    for (size_t vertex = 0; vertex < data.vertices.size(); vertex += floats_per_vertex)
+    {
+        float const* values = data.vertices.data() + vertex;
+        for (size_t i = 0; i < data.layout.size(); ++i)
+        {
+            auto const size = static_cast<size_t>(std::visit([](auto&& attr) { return attr.size(); }, data.layout[i]));
+            switch (packings[i])
+            {
+            case Packing::None:
+                for (size_t c = 0; c < size; ++c)
+                    append(values[c]);
+                break;
+            case Packing::SNorm10_10_10_2:
+                append(glm::packSnorm3x10_1x2(glm::vec4{values[0], values[1], values[2], 0.f}));
+                break;
+            case Packing::Half2:
+                append(glm::packHalf2x16(glm::vec2{values[0], values[1]}));
+                break;
+            case Packing::Half4:
+                append(glm::packHalf4x16(glm::vec4{values[0], values[1], values[2], values[3]}));
+                break;
+            }
+            values += size;
+        }
+    }
+    return res;
+}
+
+auto make_mesh(PackedVertices const& vertices, std::span<uint32_t const> indices) -> Mesh
+{
+    auto const vertex_buffers = std::vector<VertexBuffer_RawDescriptor>{{.layout = vertices.layout, .data = vertices.data}};
+    if (smallest_index_type(vertices.vertices_count()) == IndexType::UInt16)
+    {
+        auto const indices_16_bit = std::vector<uint16_t>(indices.begin(), indices.end());
+        return Mesh{{
+            .vertex_buffers = vertex_buffers,
+            .index_buffer   = std::as_bytes(std::span{indices_16_bit}),
+            .index_type     = IndexType::UInt16,
+        }};
+    }
+    return Mesh{{
+        .vertex_buffers = vertex_buffers,
+        .index_buffer   = std::as_bytes(indices),
+        .index_type     = IndexType::UInt32,
+    }};
+}
+
+auto make_mesh(MeshData const& data, VertexFormat format) -> Mesh
+{
+    return make_mesh(pack_vertices(data, format), data.indices);
+}
+
+auto make_shared_mesh(MeshData const& data, VertexFormat format) -> SharedMesh
+{
+    auto const vertices = pack_vertices(data, format);
+    return MeshPool::shared(vertices.layout).add(vertices.data, data.indices);
+}
+
+auto load_mesh(std::filesystem::path const& path, LoadMesh_Options const& options) -> Mesh
+{
+    if (!options.use_cache)
+        return make_mesh(load_mesh_data(path, options), options.vertex_format);
+
+    auto const start         = std::chrono::steady_clock::now();
+    auto const absolute_path = make_absolute_path(path);
+    auto const cache_path    = options.cache_path.value_or(std::filesystem::path{absolute_path}.replace_extension(".meshcache"));
+    auto const key           = internal::mesh_cache_key(absolute_path, options);
+    if (auto mesh = internal::load_mesh_cache(cache_path, key))
+    {
+        if (options.log_stats)
+        {
+            auto const duration = std::chrono::duration<float, std::milli>{std::chrono::steady_clock::now() - start};
+            std::cout << std::format("[load_mesh] Loaded \"{}\" from the cache in {:.2f} ms", path.string(), duration.count()) << '\n';
+        }
+        return std::move(*mesh);
+    }
+
+    auto const data     = load_mesh_data(path, options);
+    auto const vertices = pack_vertices(data, options.vertex_format);
+    internal::save_mesh_cache(cache_path, key, vertices, data.indices);
+    return make_mesh(vertices, data.indices);
+}
+
+} // namespace gl
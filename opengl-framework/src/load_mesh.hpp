@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+#include "Mesh.hpp"
+#include "MeshPool.hpp"
+
+namespace gl {
+
+/// A mesh that lives on the CPU: interleaved vertices and a triangle index buffer.
+struct MeshData {
+    std::vector<AnyVertexAttribute> layout{};   /// Describes one vertex of the `vertices` array
+    std::vector<float>              vertices{}; /// Interleaved attributes of all the vertices
+    std::vector<uint32_t>           indices{};  /// 3 indices per triangle
+
+    auto floats_per_vertex() const -> size_t;
+    auto vertices_count() const -> size_t { return vertices.size() / floats_per_vertex(); }
+};
+
+/// How the vertices are stored on the GPU
+enum class VertexFormat {
+    Float,   /// All the attributes are stored as floats, exactly like in MeshData
+    Compact, /// The position (location 0) stays as floats, vec3 attributes in [-1, 1] (e.g. normals) become SNorm10_10_10_2, and vec2 and vec4 attributes become half-floats. This roughly halves the size of the vertices, and the shaders don't need to change.
+};
+
+/// Vertices in the exact format that will be uploaded to the GPU
+struct PackedVertices {
+    std::vector<AnyVertexAttribute> layout{};
+    std::vector<std::byte>          data{};
+
+    auto bytes_per_vertex() const -> size_t;
+    auto vertices_count() const -> size_t { return data.size() / bytes_per_vertex(); }
+};
+
+auto pack_vertices(MeshData const&, VertexFormat) -> PackedVertices;
+
+struct LoadMesh_Options {
+    bool log_stats{true}; /// Prints the load time and the number of vertices and triangles to the console
+    /// Parses the file with the multithreaded parser of tinyobjloader instead of the classic one. Much faster on big meshes, and produces the same MeshData.
+    bool         multithreaded{false};
+    unsigned int threads_count{0}; /// Number of threads used by the multithreaded parser. 0 means gl::threads_count().
+    bool         optimize{true};   /// Reorders the triangles and vertices for the GPU caches, see optimize_mesh()
+    VertexFormat vertex_format{VertexFormat::Float}; /// Only used by load_mesh()
+    /// load_mesh() stores the imported mesh in a binary file that can be memory-mapped and uploaded as is, which makes subsequent loads much faster.
+    /// The cache is automatically rebuilt when the .obj file changes.
+    bool                                 use_cache{true};
+    std::optional<std::filesystem::path> cache_path{}; /// Defaults to the path of the .obj file, with a .meshcache extension
+};
+
+/// Loads a .obj file. All its shapes are merged into a single mesh.
+/// The vertices are interleaved and use the layout {Position3D{0}, Normal3D{1}, UV{2}} (missing normals and UVs are set to 0).
+/// Identical (position, normal, uv) combinations are only stored once, and referenced through the index buffer.
+/// Unless `optimize` is false, the triangles and vertices are then reordered by optimize_mesh().
+auto load_mesh_data(std::filesystem::path const& path, LoadMesh_Options const& = {}) -> MeshData;
+
+/// Uploads the mesh to the GPU. 16-bit indices are used whenever there are few enough vertices.
+auto make_mesh(MeshData const&, VertexFormat = VertexFormat::Float) -> Mesh;
+auto make_mesh(PackedVertices const&, std::span<uint32_t const> indices) -> Mesh;
+/// Same as make_mesh(), but the mesh is stored in the MeshPool::shared() of its layout, alongside all the other meshes that use the same VertexFormat.
+auto make_shared_mesh(MeshData const&, VertexFormat = VertexFormat::Float) -> SharedMesh;
+
+/// Loads a .obj file into a Mesh. See load_mesh_data() for more details.
+/// If `use_cache` is true (the default), the mesh is loaded from the cache file whenever it is up-to-date.
+auto load_mesh(std::filesystem::path const& path, LoadMesh_Options const& = {}) -> Mesh;
+
+} // namespace gl
@@ -0,0 +1,164 @@
+#include "mesh_cache.hpp"
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include "MappedFile.hpp"
+
+namespace gl::internal {
+
+namespace {
+
+constexpr auto     cache_magic   = std::array<char, 8>{'G', 'L', 'M', 'E', 'S', 'H', '\0', '\0'};
+constexpr uint32_t cache_version = 3;
+constexpr uint64_t blob_alignment = 16;
+
+struct CacheHeader {
+    std::array<char, 8> magic{};
+    uint32_t            version{};
+    uint32_t            index_type{};
+    MeshCacheKey        key{};
+    uint32_t            attributes_count{};
+    uint32_t            reserved{};
+    uint64_t            vertices_offset{};
+    uint64_t            vertices_size{};
+    uint64_t            indices_offset{};
+    uint64_t            indices_size{};
+};
+static_assert(sizeof(CacheHeader) == 80);
+
+struct CachedAttribute {
+    uint32_t kind{};  // Index of the type in the AnyVertexAttribute variant
+    int32_t  index{}; // Location in the shader
+};
+
+template<size_t... Kinds>
+auto make_attribute(uint32_t kind, int index, std::index_sequence<Kinds...>) -> AnyVertexAttribute
+{
+    auto res = AnyVertexAttribute{VertexAttribute::Float{index}};
+    ((kind == Kinds ? (res = std::variant_alternative_t<Kinds, AnyVertexAttribute>{index}, true) : false) || ...);
+    return res;
+}
+
+auto align(uint64_t offset) -> uint64_t
+{
+    return (offset + blob_alignment - 1) / blob_alignment * blob_alignment;
+}
+
+auto is_valid(CacheHeader const& header, MeshCacheKey const& key, size_t file_size) -> bool
+{
+    auto const attributes_end = sizeof(CacheHeader) + header.attributes_count * sizeof(CachedAttribute);
+    return header.magic == cache_magic
+           && header.version == cache_version
+           && header.key == key
+           && header.attributes_count > 0
+           && attributes_end <= file_size
+           && header.vertices_offset >= attributes_end
+           && header.vertices_offset + header.vertices_size <= file_size
+           && header.indices_offset + header.indices_size <= file_size
+           && (header.index_type == static_cast<uint32_t>(IndexType::UInt16) || header.index_type == static_cast<uint32_t>(IndexType::UInt32));
+}
+
+} // namespace
+
+auto mesh_cache_key(std::filesystem::path const& source_path, LoadMesh_Options const& options) -> MeshCacheKey
+{
+    return {
+        .source_size            = std::filesystem::file_size(source_path),
+        .source_last_write_time = static_cast<int64_t>(std::filesystem::last_write_time(source_path).time_since_epoch().count()),
+        .options                = (options.optimize ? 1u : 0u) | static_cast<uint64_t>(options.vertex_format) << 1,
+    };
+}
+
+auto load_mesh_cache(std::filesystem::path const& cache_path, MeshCacheKey const& key) -> std::optional<Mesh>
+{
+    auto const file = MappedFile::open(cache_path);
+    if (!file || file->bytes().size() < sizeof(CacheHeader))
+        return std::nullopt;
+    auto const bytes = file->bytes();
+
+    auto header = CacheHeader{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (!is_valid(header, key, bytes.size()))
+        return std::nullopt;
+
+    auto layout = std::vector<AnyVertexAttribute>{};
+    for (uint32_t i = 0; i < header.attributes_count; ++i)
+    {
+        auto attribute = CachedAttribute{};
+        std::memcpy(&attribute, bytes.data() + sizeof(CacheHeader) + i * sizeof(CachedAttribute), sizeof(attribute));
+        if (attribute.kind >= std::variant_size_v<AnyVertexAttribute>)
+            return std::nullopt;
+        layout.push_back(make_attribute(attribute.kind, attribute.index, std::make_index_sequence<std::variant_size_v<AnyVertexAttribute>>{}));
+    }
+
+    // The GPU reads straight from the mapped file
+    return Mesh{{
+        .vertex_buffers = {{.layout = layout, .data = bytes.subspan(header.vertices_offset, header.vertices_size)}},
+        .index_buffer   = bytes.subspan(header.indices_offset, header.indices_size),
+        .index_type     = static_cast<IndexType>(header.index_type),
+    }};
+}
+
+void save_mesh_cache(std::filesystem::path const& cache_path, MeshCacheKey const& key, PackedVertices const& vertices, std::span<uint32_t const> indices)
+{
+    auto const index_type     = smallest_index_type(vertices.vertices_count());
+    auto const indices_16_bit = index_type == IndexType::UInt16
+                                    ? std::vector<uint16_t>(indices.begin(), indices.end())
+                                    : std::vector<uint16_t>{};
+    auto const indices_bytes  = index_type == IndexType::UInt16
+                                    ? std::as_bytes(std::span{indices_16_bit})
+                                    : std::as_bytes(indices);
+    auto const vertices_bytes = std::span{vertices.data};
+
+    auto header = CacheHeader{
+        .magic            = cache_magic,
+        .version          = cache_version,
+        .index_type       = static_cast<uint32_t>(index_type),
+        .key              = key,
+        .attributes_count = static_cast<uint32_t>(vertices.layout.size()),
+    };
+    header.vertices_offset = align(sizeof(CacheHeader) + vertices.layout.size() * sizeof(CachedAttribute));
+    header.vertices_size   = vertices_bytes.size();
+    header.indices_offset  = align(header.vertices_offset + header.vertices_size);
+    header.indices_size    = indices_bytes.size();
+
+    // Write to a temporary file first, so that a crash never leaves a half-written cache behind
+    auto temporary_path = cache_path;
+    temporary_path += ".tmp";
+    {
+        auto       file  = std::ofstream{temporary_path, std::ios::binary};
+        auto const write = [&](void const* src, size_t size) {
+            file.write(static_cast<char const*>(src), static_cast<std::streamsize>(size));
+        };
+        auto const pad_to = [&](uint64_t offset) {
+            auto const padding = std::array<char, blob_alignment>{};
+            write(padding.data(), offset - static_cast<uint64_t>(file.tellp()));
+        };
+        write(&header, sizeof(header));
+        for (auto const& attribute : vertices.layout)
+        {
+            auto const cached = CachedAttribute{
+                .kind  = static_cast<uint32_t>(attribute.index()),
+                .index = std::visit([](auto&& attr) { return attr.index(); }, attribute),
+            };
+            write(&cached, sizeof(cached));
+        }
+        pad_to(header.vertices_offset);
+        write(vertices_bytes.data(), vertices_bytes.size());
+        pad_to(header.indices_offset);
+        write(indices_bytes.data(), indices_bytes.size());
+        if (!file)
+        {
+            std::cerr << "[load_mesh] Failed to write the cache file \"" << temporary_path.string() << "\"\n";
+            return;
+        }
+    }
+    auto error = std::error_code{};
+    std::filesystem::rename(temporary_path, cache_path, error);
+    if (error)
+        std::cerr << "[load_mesh] Failed to write the cache file \"" << cache_path.string() << "\": " << error.message() << '\n';
+}
+
+} // namespace gl::internal
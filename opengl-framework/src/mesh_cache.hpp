@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include "Mesh.hpp"
+#include "load_mesh.hpp"
+
+namespace gl::internal {
+
+/// Identifies the version of the .obj file that a cache has been created from, so that we know when the cache is outdated.
+struct MeshCacheKey {
+    uint64_t source_size{};
+    int64_t  source_last_write_time{};
+    uint64_t options{}; /// The LoadMesh_Options that change the content of the mesh
+
+    friend auto operator==(MeshCacheKey const&, MeshCacheKey const&) -> bool = default;
+};
+
+auto mesh_cache_key(std::filesystem::path const& source_path, LoadMesh_Options const&) -> MeshCacheKey;
+
+/// Memory-maps the cache file and uploads its vertex and index blobs directly to the GPU, without any intermediate copy.
+/// Returns std::nullopt if the file doesn't exist, is invalid, or was created from another version of the source file.
+auto load_mesh_cache(std::filesystem::path const& cache_path, MeshCacheKey const&) -> std::optional<Mesh>;
+
+/// The file contains a small header, the vertex layout, and then the vertex and index buffers exactly as they will be uploaded to the GPU.
+void save_mesh_cache(std::filesystem::path const& cache_path, MeshCacheKey const&, PackedVertices const&, std::span<uint32_t const> indices);
+
+} // namespace gl::internal
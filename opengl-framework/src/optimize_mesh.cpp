@@ -0,0 +1,313 @@
+#include "optimize_mesh.hpp"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <glm/glm.hpp>
+
+namespace gl {
+
+namespace {
+
+/// Simulates a FIFO cache by remembering when each vertex entered it. Resetting the cache is just a matter of advancing the time.
+class VertexCacheSimulator {
+public:
+    VertexCacheSimulator(size_t vertices_count, size_t cache_size)
+        : _entry_time(vertices_count, 0)
+        , _cache_size{cache_size}
+        , _time{cache_size + 1}
+    {}
+
+    /// Returns the number of cache misses caused by the triangle
+    auto add_triangle(uint32_t const* triangle) -> unsigned int
+    {
+        unsigned int misses = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            auto& entry_time = _entry_time[triangle[i]];
+            if (_time - entry_time > _cache_size)
+            {
+                entry_time = _time++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+
+    void reset() { _time += _cache_size + 1; }
+
+private:
+    std::vector<size_t> _entry_time;
+    size_t              _cache_size;
+    size_t              _time;
+};
+
+/// For each vertex, the list of the triangles that use it
+struct Adjacency {
+    std::vector<uint32_t> offsets{};   /// The triangles of vertex v are triangles[offsets[v]] to triangles[offsets[v + 1]]
+    std::vector<uint32_t> triangles{};
+
+    Adjacency(std::span<uint32_t const> indices, size_t vertices_count)
+        : offsets(vertices_count + 1, 0)
+        , triangles(indices.size())
+    {
+        for (uint32_t const index : indices)
+            ++offsets[index + 1];
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        auto fill = std::vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    auto triangles_count(uint32_t vertex) const -> uint32_t { return offsets[vertex + 1] - offsets[vertex]; }
+};
+
+constexpr auto no_vertex = static_cast<uint32_t>(-1);
+
+/// Returns [begin, end) ranges of triangles, that each form a contiguous patch of the mesh
+auto find_clusters(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size, float threshold) -> std::vector<std::pair<size_t, size_t>>
+{
+    size_t const triangles_count = indices.size() / 3;
+    auto         cache           = VertexCacheSimulator{vertices_count, cache_size};
+
+    // Hard boundaries: when none of the vertices of a triangle are in the cache, the optimizer has jumped to a new patch of the mesh
+    auto hard_boundaries = std::vector<size_t>{};
+    for (size_t i = 0; i < triangles_count; ++i)
+    {
+        if (cache.add_triangle(&indices[3 * i]) == 3)
+            hard_boundaries.push_back(i);
+    }
+    hard_boundaries.push_back(triangles_count);
+
+    // Soft boundaries: split the patches further, as long as each piece stays almost as cache-efficient as the whole patch
+    auto clusters = std::vector<std::pair<size_t, size_t>>{};
+    for (size_t b = 0; b + 1 < hard_boundaries.size(); ++b)
+    {
+        size_t const begin = hard_boundaries[b];
+        size_t const end   = hard_boundaries[b + 1];
+
+        cache.reset();
+        unsigned int patch_misses = 0;
+        for (size_t i = begin; i < end; ++i)
+            patch_misses += cache.add_triangle(&indices[3 * i]);
+        float const max_acmr = threshold * static_cast<float>(patch_misses) / static_cast<float>(end - begin);
+
+        cache.reset();
+        size_t       cluster_begin  = begin;
+        unsigned int cluster_misses = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            cluster_misses += cache.add_triangle(&indices[3 * i]);
+            if (static_cast<float>(cluster_misses) <= max_acmr * static_cast<float>(i + 1 - cluster_begin))
+            {
+                clusters.emplace_back(cluster_begin, i + 1);
+                cluster_begin  = i + 1;
+                cluster_misses = 0;
+                cache.reset();
+            }
+        }
+        if (cluster_begin < end)
+            clusters.emplace_back(cluster_begin, end);
+    }
+    return clusters;
+}
+
+auto position_offset(std::vector<AnyVertexAttribute> const& layout) -> std::optional<size_t>
+{
+    size_t offset = 0;
+    for (auto const& attribute : layout)
+    {
+        auto const [index, size] = std::visit([](auto&& attr) { return std::pair{attr.index(), attr.size()}; }, attribute);
+        if (index == 0)
+            return size == 3 ? std::make_optional(offset) : std::nullopt;
+        offset += static_cast<size_t>(size);
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+auto vertex_cache_stats(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size) -> VertexCacheStats
+{
+    if (indices.empty())
+        return {};
+
+    auto         cache  = VertexCacheSimulator{vertices_count, cache_size};
+    unsigned int misses = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        misses += cache.add_triangle(&indices[i]);
+
+    auto is_used = std::vector<bool>(vertices_count, false);
+    for (uint32_t const index : indices)
+        is_used[index] = true;
+    auto const used_vertices_count = std::count(is_used.begin(), is_used.end(), true);
+
+    return {
+        .acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3),
+        .atvr = static_cast<float>(misses) / static_cast<float>(used_vertices_count),
+    };
+}
+
+auto optimize_vertex_cache(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size) -> std::vector<uint32_t>
+{
+    auto const adjacency       = Adjacency{indices, vertices_count};
+    size_t     triangles_count = indices.size() / 3;
+
+    auto live_triangles = std::vector<uint32_t>(vertices_count);
+    for (uint32_t v = 0; v < vertices_count; ++v)
+        live_triangles[v] = adjacency.triangles_count(v);
+    auto entry_time  = std::vector<size_t>(vertices_count, 0);
+    auto is_emitted  = std::vector<bool>(triangles_count, false);
+    auto dead_end    = std::vector<uint32_t>{}; // Recently used vertices, where we can restart when the current fan has no more neighbours
+    auto candidates  = std::vector<uint32_t>{};
+    auto res         = std::vector<uint32_t>{};
+    res.reserve(indices.size());
+    size_t   time   = cache_size + 1;
+    uint32_t cursor = 0; // Vertices before it have already been fully processed
+
+    auto const next_vertex = [&]() -> uint32_t {
+        // Prefer the vertex that will still be in the cache after we have emitted all of its triangles, and that has been in it for the longest time
+        auto     best          = no_vertex;
+        size_t   best_priority = 0;
+        for (uint32_t const v : candidates)
+        {
+            if (live_triangles[v] == 0)
+                continue;
+            size_t const age      = time - entry_time[v];
+            size_t const priority = age + 2 * live_triangles[v] <= cache_size ? age : 0;
+            if (best == no_vertex || priority > best_priority)
+            {
+                best          = v;
+                best_priority = priority;
+            }
+        }
+        if (best != no_vertex)
+            return best;
+
+        while (!dead_end.empty())
+        {
+            auto const v = dead_end.back();
+            dead_end.pop_back();
+            if (live_triangles[v] > 0)
+                return v;
+        }
+        while (cursor < vertices_count && live_triangles[cursor] == 0)
+            ++cursor;
+        return cursor < vertices_count ? cursor : no_vertex;
+    };
+
+    for (uint32_t fan = next_vertex(); fan != no_vertex; fan = next_vertex())
+    {
+        candidates.clear();
+        for (uint32_t i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; ++i)
+        {
+            uint32_t const triangle = adjacency.triangles[i];
+            if (is_emitted[triangle])
+                continue;
+            is_emitted[triangle] = true;
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t const v = indices[3 * triangle + corner];
+                res.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live_triangles[v];
+                if (time - entry_time[v] > cache_size)
+                    entry_time[v] = time++;
+            }
+        }
+    }
+    return res;
+}
+
+auto optimize_overdraw(std::span<uint32_t const> indices, std::span<float const> positions, size_t positions_stride, size_t cache_size, float threshold) -> std::vector<uint32_t>
+{
+    size_t const vertices_count = positions.size() >= 3 ? (positions.size() - 3) / positions_stride + 1 : 0; // The last vertex might not have all its attributes after its position
+    auto const   position       = [&](uint32_t v) {
+        return glm::vec3{positions[v * positions_stride], positions[v * positions_stride + 1], positions[v * positions_stride + 2]};
+    };
+
+    auto const clusters = find_clusters(indices, vertices_count, cache_size, threshold);
+
+    auto mesh_centroid = glm::vec3{0.f};
+    for (uint32_t const index : indices)
+        mesh_centroid += position(index);
+    mesh_centroid /= static_cast<float>(std::max(indices.size(), size_t{1}));
+
+    // Clusters that face away from the center of the mesh are the most likely to occlude the other ones
+    auto sort_keys = std::vector<float>(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        auto centroid     = glm::vec3{0.f};
+        auto normal       = glm::vec3{0.f}; // Sum of the triangles' normals, weighted by their area
+        float total_area = 0.f;
+        for (size_t t = clusters[c].first; t < clusters[c].second; ++t)
+        {
+            auto const p0          = position(indices[3 * t + 0]);
+            auto const p1          = position(indices[3 * t + 1]);
+            auto const p2          = position(indices[3 * t + 2]);
+            auto const cross       = glm::cross(p1 - p0, p2 - p0);
+            float const area       = glm::length(cross);
+            centroid += (p0 + p1 + p2) / 3.f * area;
+            normal += cross;
+            total_area += area;
+        }
+        float const normal_length = glm::length(normal);
+        sort_keys[c]              = total_area > 0.f && normal_length > 0.f
+                                        ? glm::dot(centroid / total_area - mesh_centroid, normal / normal_length)
+                                        : 0.f;
+    }
+
+    auto order = std::vector<size_t>(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+    auto res = std::vector<uint32_t>{};
+    res.reserve(indices.size());
+    for (size_t const c : order)
+        res.insert(res.end(), indices.begin() + static_cast<std::ptrdiff_t>(3 * clusters[c].first), indices.begin() + static_cast<std::ptrdiff_t>(3 * clusters[c].second));
+    return res;
+}
+
+void optimize_vertex_fetch(MeshData& mesh)
+{
+    size_t const floats_per_vertex = mesh.floats_per_vertex();
+    auto         new_index         = std::vector<uint32_t>(mesh.vertices_count(), no_vertex);
+    auto         vertices          = std::vector<float>{};
+    vertices.reserve(mesh.vertices.size());
+    for (auto& index : mesh.indices)
+    {
+        if (new_index[index] == no_vertex)
+        {
+            new_index[index] = static_cast<uint32_t>(vertices.size() / floats_per_vertex);
+            auto const first = mesh.vertices.begin() + static_cast<std::ptrdiff_t>(index * floats_per_vertex);
+            vertices.insert(vertices.end(), first, first + static_cast<std::ptrdiff_t>(floats_per_vertex));
+        }
+        index = new_index[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+void optimize_mesh(MeshData& mesh, OptimizeMesh_Options const& options)
+{
+    auto const start  = std::chrono::steady_clock::now();
+    auto const before = vertex_cache_stats(mesh.indices, mesh.vertices_count(), options.cache_size);
+
+    mesh.indices = optimize_vertex_cache(mesh.indices, mesh.vertices_count(), options.cache_size);
+    if (auto const offset = position_offset(mesh.layout))
+    {
+        auto const positions = std::span{mesh.vertices}.subspan(*offset);
+        mesh.indices         = optimize_overdraw(mesh.indices, positions, mesh.floats_per_vertex(), options.cache_size, options.overdraw_threshold);
+    }
+    optimize_vertex_fetch(mesh);
+
+    if (options.log_stats)
+    {
+        auto const after    = vertex_cache_stats(mesh.indices, mesh.vertices_count(), options.cache_size);
+        auto const duration = std::chrono::duration<float, std::milli>{std::chrono::steady_clock::now() - start};
+        std::cout << std::format("[optimize_mesh] Optimized in {:.2f} ms: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", duration.count(), before.acmr, after.acmr, before.atvr, after.atvr) << '\n';
+    }
+}
+
+} // namespace gl
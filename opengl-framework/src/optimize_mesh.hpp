@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "load_mesh.hpp"
+
+namespace gl {
+
+/// Measures how well an index buffer uses the post-transform vertex cache of the GPU, by simulating a FIFO cache.
+struct VertexCacheStats {
+    float acmr{}; /// Average Cache Miss Ratio: number of vertex shader invocations per triangle. Between 0.5 (ideal grid) and 3 (no reuse at all).
+    float atvr{}; /// Average Transformed Vertex Ratio: number of vertex shader invocations per vertex. 1 is ideal.
+};
+
+auto vertex_cache_stats(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size = 16) -> VertexCacheStats;
+
+/// Reorders the triangles so that consecutive triangles share as many vertices as possible.
+/// Uses Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007): it runs in linear time and is close to the best known algorithms.
+auto optimize_vertex_cache(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size = 16) -> std::vector<uint32_t>;
+
+/// Reorders clusters of triangles so that the ones facing outwards are drawn first, which lets early depth testing reject more fragments.
+/// `indices` should have been optimized with optimize_vertex_cache() first: the clusters are cut where it restarted its fans, or where it was already inefficient,
+/// and `threshold` is the ACMR degradation that we accept in exchange of smaller clusters (1.05 means at most 5% worse).
+/// `positions` are 3 floats per vertex, `positions_stride` is the number of floats between two consecutive positions.
+auto optimize_overdraw(std::span<uint32_t const> indices, std::span<float const> positions, size_t positions_stride, size_t cache_size = 16, float threshold = 1.05f) -> std::vector<uint32_t>;
+
+/// Reorders the vertices in the order in which the index buffer first uses them, so that the vertex fetches read memory linearly.
+/// Unused vertices are removed.
+void optimize_vertex_fetch(MeshData&);
+
+struct OptimizeMesh_Options {
+    size_t cache_size{16};           /// Number of vertices that we assume the post-transform cache can hold
+    float  overdraw_threshold{1.05f}; /// See optimize_overdraw()
+    bool   log_stats{true};          /// Prints the ACMR and ATVR before and after the optimization
+};
+
+/// Runs all the optimizations: vertex cache, then overdraw, then vertex fetch.
+/// Overdraw optimization is skipped if the layout doesn't have a 3D position at location 0.
+void optimize_mesh(MeshData&, OptimizeMesh_Options const& = {});
+
+} // namespace gl
@@ -0,0 +1,187 @@
+#include "parallel_for.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gl {
+
+namespace {
+
+struct Job {
+    std::function<void(size_t)> const* chunk_fn{};
+    size_t                             chunks_count{};
+    std::atomic<size_t>                next_chunk{0};
+    std::atomic<size_t>                done_chunks{0};
+    std::mutex                         mutex{};
+    std::condition_variable            all_done{};
+    std::exception_ptr                 error{};
+};
+
+thread_local bool is_inside_job = false; // NOLINT(*avoid-non-const-global-variables)
+
+void process(Job& job)
+{
+    is_inside_job = true;
+    for (size_t i = job.next_chunk++; i < job.chunks_count; i = job.next_chunk++)
+    {
+        try
+        {
+            (*job.chunk_fn)(i);
+        }
+        catch (...)
+        {
+            auto const lock = std::lock_guard{job.mutex};
+            if (!job.error)
+                job.error = std::current_exception();
+        }
+        if (++job.done_chunks == job.chunks_count)
+        {
+            auto const lock = std::lock_guard{job.mutex};
+            job.all_done.notify_all();
+        }
+    }
+    is_inside_job = false;
+}
+
+class ThreadPool { // NOLINT(*special-member-functions)
+public:
+    explicit ThreadPool(unsigned int workers_count)
+    {
+        for (unsigned int i = 0; i < workers_count; ++i)
+            _workers.emplace_back([this]() { worker_loop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            auto const lock = std::lock_guard{_mutex};
+            _stop           = true;
+        }
+        _wake_up.notify_all();
+        for (auto& worker : _workers)
+            worker.join();
+    }
+
+    void run(size_t chunks_count, std::function<void(size_t)> const& chunk_fn)
+    {
+        auto const run_lock = std::lock_guard{_run_mutex}; // Only one job at a time
+
+        auto job          = std::make_shared<Job>();
+        job->chunk_fn     = &chunk_fn;
+        job->chunks_count = chunks_count;
+        {
+            auto const lock = std::lock_guard{_mutex};
+            _job            = job;
+            ++_generation;
+        }
+        _wake_up.notify_all();
+
+        process(*job); // The calling thread helps too
+        {
+            auto lock = std::unique_lock{job->mutex};
+            job->all_done.wait(lock, [&]() { return job->done_chunks == job->chunks_count; });
+        }
+        {
+            auto const lock = std::lock_guard{_mutex};
+            _job.reset();
+        }
+        if (job->error)
+            std::rethrow_exception(job->error);
+    }
+
+private:
+    void worker_loop()
+    {
+        uint64_t seen_generation = 0;
+        while (true)
+        {
+            std::shared_ptr<Job> job;
+            {
+                auto lock = std::unique_lock{_mutex};
+                _wake_up.wait(lock, [&]() { return _stop || _generation != seen_generation; });
+                if (_stop)
+                    return;
+                seen_generation = _generation;
+                job             = _job; // Keeps the job alive even if we are late and it has already been completed by the other threads
+            }
+            if (job)
+                process(*job);
+        }
+    }
+
+private:
+    std::vector<std::thread> _workers{};
+    std::mutex               _mutex{};
+    std::mutex               _run_mutex{};
+    std::condition_variable  _wake_up{};
+    std::shared_ptr<Job>     _job{};
+    uint64_t                 _generation{0};
+    bool                     _stop{false};
+};
+
+struct PoolState {
+    std::mutex                  mutex{};
+    unsigned int                threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
+    std::shared_ptr<ThreadPool> pool{}; /// shared_ptr, so that set_threads_count() can replace it while a parallel_for() is still using it
+};
+
+auto pool_state() -> PoolState&
+{
+    static auto instance = PoolState{};
+    return instance;
+}
+
+/// The caller keeps the pool alive for as long as it holds the returned pointer, even if set_threads_count() is called in the meantime
+auto thread_pool() -> std::shared_ptr<ThreadPool>
+{
+    auto&      state = pool_state();
+    auto const lock  = std::lock_guard{state.mutex};
+    if (!state.pool)
+        state.pool = std::make_shared<ThreadPool>(state.threads_count - 1);
+    return state.pool;
+}
+
+} // namespace
+
+auto threads_count() -> unsigned int
+{
+    auto&      state = pool_state();
+    auto const lock  = std::lock_guard{state.mutex};
+    return state.threads_count;
+}
+
+void set_threads_count(unsigned int count)
+{
+    auto&      state = pool_state();
+    auto const lock  = std::lock_guard{state.mutex};
+    state.threads_count = std::max(count, 1u);
+    state.pool.reset(); // Will be recreated lazily with the new number of threads. A job that is still running keeps the old pool alive until it is done.
+}
+
+void parallel_for(size_t count, size_t grain_size, std::function<void(size_t begin, size_t end)> const& fn)
+{
+    if (count == 0)
+        return;
+
+    size_t const threads    = threads_count();
+    size_t const chunk_size = std::max({grain_size, size_t{1}, (count + threads * 4 - 1) / (threads * 4)}); // A few chunks per thread to balance the load
+    size_t const chunks     = (count + chunk_size - 1) / chunk_size;
+    if (threads == 1 || chunks == 1 || is_inside_job)
+    {
+        fn(0, count);
+        return;
+    }
+
+    auto const pool = thread_pool();
+    pool->run(chunks, [&](size_t chunk) {
+        size_t const begin = chunk * chunk_size;
+        fn(begin, std::min(begin + chunk_size, count));
+    });
+}
+
+} // namespace gl
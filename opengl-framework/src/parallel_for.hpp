@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace gl {
+
+/// Number of threads used by parallel_for(), including the calling thread.
+/// Defaults to std::thread::hardware_concurrency().
+auto threads_count() -> unsigned int;
+/// Changes the number of threads used by parallel_for(). 1 means that everything runs on the calling thread.
+/// It can be called while another thread is inside parallel_for(): that job finishes on the previous threads.
+void set_threads_count(unsigned int count);
+
+/// Splits [0, count) into contiguous chunks of at least `grain_size` elements, and calls `fn(begin, end)` on each of them, from several threads.
+/// Returns once all the chunks have been processed. If `fn` throws, the first exception is rethrown on the calling thread.
+/// Calling parallel_for() from inside `fn` is allowed, but the nested loop will run on a single thread.
+void parallel_for(size_t count, size_t grain_size, std::function<void(size_t begin, size_t end)> const& fn);
+
+} // namespace gl
@@ -63,7 +63,7 @@ int main()
         glClearColor(0.f, 0.f, 1.f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shader.bind();
-        shader.set_uniform("_view_projection_matrix", glm::infinitePerspective(1.f, gl::window_aspect_ratio(), 0.001f) * camera.view_matrix());
+        shader.set_uniform("_view_projection_matrix", camera.view_projection_matrix(gl::window_aspect_ratio()));
         triangle_mesh.draw();
         // camera.rotate(0.01f, {0.f, 0.f, 1.f});
         // Ensuite dessinez un carré
@@ -0,0 +1,291 @@
+#include "barnes_hut.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include "morton.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "radix_sort.hpp"
+
+namespace {
+
+constexpr uint32_t max_level = 16; // Morton codes have 16 bits per axis
+
+struct BuildTask {
+    size_t   node_index;
+    size_t   begin;
+    size_t   end;
+    uint32_t level;
+};
+
+/// When building the top of the tree, the small subtrees are deferred so that they can be built in parallel.
+/// The inner nodes above them can only be aggregated afterwards.
+struct Deferred {
+    std::vector<BuildTask> subtrees{};
+    std::vector<BuildTask> inner_nodes{};
+};
+
+auto quadrant(uint32_t code, uint32_t level) -> uint32_t
+{
+    return (code >> (30 - 2 * level)) & 3u;
+}
+
+struct Builder {
+    std::span<uint32_t const>  codes;
+    std::span<glm::vec2 const> positions;
+    std::span<float const>     masses;
+    uint32_t                   leaf_size;
+    glm::vec2                  root_min;
+    float                      root_size;
+
+    auto cell_center(size_t first_particle, uint32_t level) const -> glm::vec2
+    {
+        auto const  code      = codes[first_particle];
+        auto const  cell      = glm::uvec2{morton::compact_1_by_1(code), morton::compact_1_by_1(code >> 1)} >> (max_level - level);
+        float const cell_size = root_size / static_cast<float>(1u << level);
+        return root_min + (glm::vec2{cell} + 0.5f) * cell_size;
+    }
+
+    /// Builds the node that contains the particles [begin, end), whose codes all share their first `level` quadrants
+    void build(std::vector<Quadtree::Node>& nodes, size_t node_index, size_t begin, size_t end, uint32_t level, Deferred* deferred = nullptr, size_t task_size = 0) const
+    {
+        nodes[node_index].size = root_size / static_cast<float>(1u << level);
+        if (deferred != nullptr && end - begin <= task_size)
+        {
+            deferred->subtrees.push_back({.node_index = node_index, .begin = begin, .end = end, .level = level});
+            return;
+        }
+        if (end - begin <= leaf_size || level == max_level)
+        {
+            auto& node           = nodes[node_index];
+            node.first           = static_cast<uint32_t>(begin);
+            node.particles_count = static_cast<uint32_t>(end - begin);
+            node.children_count  = 0;
+            node.mass            = 0.f;
+            auto weighted_sum    = glm::vec2{0.f};
+            for (size_t i = begin; i < end; ++i)
+            {
+                node.mass += masses[i];
+                weighted_sum += masses[i] * positions[i];
+            }
+            node.center_of_mass = node.mass > 0.f ? weighted_sum / node.mass : positions[begin];
+            node.center_offset  = glm::distance(node.center_of_mass, cell_center(begin, level));
+            return;
+        }
+
+        // The particles are sorted, so each quadrant is a contiguous range
+        auto bounds = std::array<size_t, 5>{begin, 0, 0, 0, end};
+        for (uint32_t q = 1; q < 4; ++q)
+        {
+            bounds[q] = static_cast<size_t>(std::partition_point(codes.begin() + static_cast<std::ptrdiff_t>(bounds[q - 1]), codes.begin() + static_cast<std::ptrdiff_t>(end), [&](uint32_t code) {
+                            return quadrant(code, level) < q;
+                        })
+                        - codes.begin());
+        }
+
+        auto const first_child = nodes.size();
+        uint32_t   children    = 0;
+        for (uint32_t q = 0; q < 4; ++q)
+        {
+            if (bounds[q] < bounds[q + 1])
+                children++;
+        }
+        nodes[node_index].first           = static_cast<uint32_t>(first_child);
+        nodes[node_index].children_count  = children;
+        nodes[node_index].particles_count = static_cast<uint32_t>(end - begin);
+        nodes.resize(nodes.size() + children);
+        size_t child = first_child;
+        for (uint32_t q = 0; q < 4; ++q)
+        {
+            if (bounds[q] < bounds[q + 1])
+                build(nodes, child++, bounds[q], bounds[q + 1], level + 1, deferred, task_size);
+        }
+        if (deferred != nullptr)
+            deferred->inner_nodes.push_back({.node_index = node_index, .begin = begin, .end = end, .level = level});
+        else
+            aggregate(nodes, node_index, begin, level);
+    }
+
+    void aggregate(std::vector<Quadtree::Node>& nodes, size_t node_index, size_t begin, uint32_t level) const
+    {
+        auto& node        = nodes[node_index];
+        node.mass         = 0.f;
+        auto weighted_sum = glm::vec2{0.f};
+        for (uint32_t i = node.first; i < node.first + node.children_count; ++i)
+        {
+            node.mass += nodes[i].mass;
+            weighted_sum += nodes[i].mass * nodes[i].center_of_mass;
+        }
+        node.center_of_mass = node.mass > 0.f ? weighted_sum / node.mass : nodes[node.first].center_of_mass;
+        node.center_offset  = glm::distance(node.center_of_mass, cell_center(begin, level));
+    }
+};
+
+auto attraction(glm::vec2 position, glm::vec2 other, float mass, Gravity_Options const& options) -> glm::vec2
+{
+    auto const  delta            = other - position;
+    float const distance_squared = glm::dot(delta, delta) + options.softening * options.softening;
+    return delta * (options.gravitational_constant * mass / (distance_squared * std::sqrt(distance_squared)));
+}
+
+} // namespace
+
+void Quadtree::build(std::span<Particle const> particles, uint32_t leaf_size)
+{
+    _nodes.clear();
+    size_t const count = particles.size();
+    if (count == 0)
+        return;
+
+    auto min = particles[0].position;
+    auto max = particles[0].position;
+    for (auto const& particle : particles)
+    {
+        min = glm::min(min, particle.position);
+        max = glm::max(max, particle.position);
+    }
+    float const size = std::max({max.x - min.x, max.y - min.y, 1e-6f}) * 1.0001f; // Slightly bigger, so that the particles on the max border don't get clamped into the same cell as their neighbours
+
+    _sorted_codes.resize(count);
+    _sorted_indices.resize(count);
+    gl::parallel_for(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            _sorted_codes[i]   = morton::encode(particles[i].position, min, size);
+            _sorted_indices[i] = static_cast<uint32_t>(i);
+        }
+    });
+    radix_sort(_sorted_codes, _sorted_indices);
+
+    _sorted_positions.resize(count);
+    _sorted_masses.resize(count);
+    gl::parallel_for(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto const& particle = particles[_sorted_indices[i]];
+            _sorted_positions[i] = particle.position;
+            _sorted_masses[i]    = particle.mass;
+        }
+    });
+
+    auto const builder = Builder{.codes = _sorted_codes, .positions = _sorted_positions, .masses = _sorted_masses, .leaf_size = std::max(leaf_size, 1u), .root_min = min, .root_size = size};
+    _nodes.emplace_back();
+    if (count < 16384 || gl::threads_count() <= 1)
+    {
+        builder.build(_nodes, 0, 0, count, 0);
+        return;
+    }
+
+    auto deferred = Deferred{};
+    builder.build(_nodes, 0, 0, count, 0, &deferred, std::max<size_t>(count / (gl::threads_count() * 8), 1024));
+    auto const& tasks = deferred.subtrees;
+
+    auto subtrees = std::vector<std::vector<Node>>(tasks.size());
+    gl::parallel_for(tasks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            subtrees[i].emplace_back();
+            builder.build(subtrees[i], 0, tasks[i].begin, tasks[i].end, tasks[i].level);
+        }
+    });
+
+    // Append the subtrees, their root replaces the node that was waiting for them
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        auto const shift  = static_cast<uint32_t>(_nodes.size() - 1);
+        auto const rebase = [&](Node node) {
+            if (node.children_count > 0)
+                node.first += shift;
+            return node;
+        };
+        _nodes[tasks[i].node_index] = rebase(subtrees[i][0]);
+        std::transform(subtrees[i].begin() + 1, subtrees[i].end(), std::back_inserter(_nodes), rebase);
+    }
+    // Now that the subtrees are known, compute the masses of the top of the tree. The inner nodes were recorded after their children, so this goes bottom-up.
+    for (auto const& node : deferred.inner_nodes)
+        builder.aggregate(_nodes, node.node_index, node.begin, node.level);
+}
+
+auto Quadtree::acceleration(glm::vec2 position, Gravity_Options const& options) const -> glm::vec2
+{
+    auto res = glm::vec2{0.f};
+    if (_nodes.empty())
+        return res;
+
+    auto        stack         = std::array<uint32_t, 4 * max_level + 4>{};
+    size_t      stack_size    = 0;
+    stack[stack_size++]       = 0;
+    while (stack_size > 0)
+    {
+        auto const& node             = _nodes[stack[--stack_size]];
+        auto const  delta            = node.center_of_mass - position;
+        float const distance_squared = glm::dot(delta, delta);
+        // Far enough to be seen as a single body. Taking the offset of the center of mass into account avoids big errors for particles that are close to a cell whose mass is concentrated on its far side.
+        float const opening_distance = node.size / options.theta + node.center_offset;
+        if (options.theta > 0.f && distance_squared > opening_distance * opening_distance)
+        {
+            res += attraction(position, node.center_of_mass, node.mass, options);
+        }
+        else if (node.children_count == 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.particles_count; ++i)
+                res += attraction(position, _sorted_positions[i], _sorted_masses[i], options);
+        }
+        else
+        {
+            for (uint32_t i = node.first; i < node.first + node.children_count; ++i)
+                stack[stack_size++] = i;
+        }
+    }
+    return res;
+}
+
+void compute_gravity(Quadtree const& tree, std::span<Particle const> particles, std::span<glm::vec2> accelerations, Gravity_Options const& options)
+{
+    gl::parallel_for(particles.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            accelerations[i] = tree.acceleration(particles[i].position, options);
+    });
+}
+
+void compute_gravity_brute_force(std::span<Particle const> particles, std::span<glm::vec2> accelerations, Gravity_Options const& options)
+{
+    gl::parallel_for(particles.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto acceleration = glm::vec2{0.f};
+            for (auto const& other : particles)
+                acceleration += attraction(particles[i].position, other.position, other.mass, options);
+            accelerations[i] = acceleration;
+        }
+    });
+}
+
+auto measure_gravity_accuracy(std::span<Particle const> particles, Gravity_Options const& options) -> GravityAccuracyReport
+{
+    using clock       = std::chrono::steady_clock;
+    auto approximated = std::vector<glm::vec2>(particles.size());
+    auto exact        = std::vector<glm::vec2>(particles.size());
+
+    auto const start = clock::now();
+    auto       tree  = Quadtree{};
+    tree.build(particles, options.leaf_size);
+    compute_gravity(tree, particles, approximated, options);
+    auto const tree_end = clock::now();
+    compute_gravity_brute_force(particles, exact, options);
+    auto const brute_end = clock::now();
+
+    auto   res       = GravityAccuracyReport{};
+    double error_sum = 0.;
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        float const error = glm::length(approximated[i] - exact[i]) / std::max(glm::length(exact[i]), 1e-12f);
+        error_sum += error;
+        res.max_relative_error = std::max(res.max_relative_error, error);
+    }
+    res.mean_relative_error      = particles.empty() ? 0.f : static_cast<float>(error_sum / static_cast<double>(particles.size()));
+    res.tree_milliseconds        = std::chrono::duration<double, std::milli>(tree_end - start).count();
+    res.brute_force_milliseconds = std::chrono::duration<double, std::milli>(brute_end - tree_end).count();
+    return res;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "particle.hpp"
+
+struct Gravity_Options {
+    float    gravitational_constant{0.0005f};
+    float    softening{0.02f}; /// Distance added to all the distances, so that the force doesn't explode when two particles get very close
+    float    theta{0.5f};      /// Opening angle: a cell is replaced by its center of mass when size / distance < theta. 0 gives the exact result, bigger is faster but less accurate.
+    uint32_t leaf_size{8};     /// Maximum number of particles in a leaf of the quadtree
+};
+
+/// Barnes–Hut quadtree: far away groups of particles are approximated by their center of mass, which brings the cost of the n-body gravity from O(n²) down to O(n log n).
+/// The particles are sorted along a Z-order curve, so that each cell of the tree is a contiguous range of particles, and the tree is built top-down by splitting these ranges.
+/// The top of the tree is built on one thread, and the subtrees in parallel.
+class Quadtree {
+public:
+    void build(std::span<Particle const> particles, uint32_t leaf_size = 8);
+    /// Acceleration caused by all the particles that were given to build(). A particle at exactly `position` doesn't attract itself.
+    auto acceleration(glm::vec2 position, Gravity_Options const&) const -> glm::vec2;
+
+    auto nodes_count() const -> size_t { return _nodes.size(); }
+
+    struct Node {
+        glm::vec2 center_of_mass{};
+        float     mass{};
+        float     size{};           /// Width of the square cell
+        float     center_offset{};  /// Distance between the center of mass and the center of the cell
+        uint32_t  first{};          /// First child (the other ones follow it), or first particle if this is a leaf
+        uint32_t  children_count{}; /// Between 1 and 4, or 0 for leaves
+        uint32_t  particles_count{};
+    };
+
+private:
+    std::vector<Node>      _nodes{};
+    std::vector<uint32_t>  _sorted_codes{};     /// Morton code of each particle, in increasing order
+    std::vector<uint32_t>  _sorted_indices{};   /// Index of each particle in the span that was given to build()
+    std::vector<glm::vec2> _sorted_positions{}; /// In Morton order
+    std::vector<float>     _sorted_masses{};
+};
+
+/// Fills `accelerations` with the gravity that all the particles apply to each other, in parallel
+void compute_gravity(Quadtree const&, std::span<Particle const>, std::span<glm::vec2> accelerations, Gravity_Options const&);
+void compute_gravity_brute_force(std::span<Particle const>, std::span<glm::vec2> accelerations, Gravity_Options const&);
+
+struct GravityAccuracyReport {
+    float  mean_relative_error{};
+    float  max_relative_error{};
+    double tree_milliseconds{};        /// Build + evaluation
+    double brute_force_milliseconds{};
+};
+
+/// Compares the Barnes–Hut approximation with the exact O(n²) sum
+auto measure_gravity_accuracy(std::span<Particle const>, Gravity_Options const&) -> GravityAccuracyReport;
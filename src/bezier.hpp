@@ -0,0 +1,54 @@
+#pragma once
+#include <limits>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+
+inline glm::vec2 bezier3_bernstein(const glm::vec2& p0,
+                                   const glm::vec2& p1,
+                                   const glm::vec2& p2,
+                                   const glm::vec2& p3,
+                                   float t)
+{
+    float u = 1.f - t;
+    return p0*(u*u*u)
+         + p1*(3.f*u*u*t)
+         + p2*(3.f*u*t*t)
+         + p3*(t*t*t);
+}
+
+inline glm::vec2 bezier3_tangent(const glm::vec2& p0,
+                                 const glm::vec2& p1,
+                                 const glm::vec2& p2,
+                                 const glm::vec2& p3,
+                                 float t)
+{
+    float u = 1.f - t;
+    return 3.f*(u*u)*(p1 - p0)
+         + 6.f*u*t*(p2 - p1)
+         + 3.f*(t*t)*(p3 - p2);
+}
+
+inline float findClosestT(const glm::vec2& p0,
+                          const glm::vec2& p1,
+                          const glm::vec2& p2,
+                          const glm::vec2& p3,
+                          const glm::vec2& P)
+{
+    const int SAMPLES = 20;
+    float bestT = 0.f;
+    float bestD = std::numeric_limits<float>::infinity();
+    for (int i = 0; i <= SAMPLES; ++i) {
+        float t = float(i)/float(SAMPLES);
+        float d = glm::distance2(bezier3_bernstein(p0,p1,p2,p3,t), P);
+        if (d < bestD) { bestD = d; bestT = t; }
+    }
+    float t = bestT;
+    const float alpha = 0.2f;
+    for (int iter = 0; iter < 30; ++iter) {
+        glm::vec2 B = bezier3_bernstein(p0,p1,p2,p3,t);
+        glm::vec2 T = bezier3_tangent(p0,p1,p2,p3,t);
+        float grad = 2.f * glm::dot(B - P, T);
+        t = glm::clamp(t - alpha * grad, 0.f, 1.f);
+    }
+    return t;
+}
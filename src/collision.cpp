@@ -0,0 +1,231 @@
+#include "collision.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace collision {
+
+static auto closest_point_on_segment(glm::vec2 p, Segment const& segment) -> glm::vec2
+{
+    auto const  edge           = segment.b - segment.a;
+    float const length_squared = glm::dot(edge, edge);
+    if (length_squared < 1e-12f)
+        return segment.a;
+    return segment.a + glm::clamp(glm::dot(p - segment.a, edge) / length_squared, 0.f, 1.f) * edge;
+}
+
+/// A disk sweeping against a segment is the same as its center (a point) sweeping against the segment inflated by the radius: a capsule made of two sides and two round caps
+static auto sweep_segment(glm::vec2 from, glm::vec2 motion, float radius, Segment const& segment) -> std::optional<SweepHit>
+{
+    // Already touching: push the particle out, unless it is already moving away
+    auto const  closest          = closest_point_on_segment(from, segment);
+    auto const  to_particle      = from - closest;
+    float const distance_squared = glm::dot(to_particle, to_particle);
+    auto const  edge             = segment.b - segment.a;
+    float const edge_length      = glm::length(edge);
+    auto const  edge_normal      = edge_length > 1e-6f ? glm::vec2{-edge.y, edge.x} / edge_length : glm::vec2{0.f, 1.f};
+    if (distance_squared < radius * radius)
+    {
+        auto normal = distance_squared > 1e-12f ? to_particle / std::sqrt(distance_squared) : edge_normal;
+        if (glm::dot(motion, normal) >= 0.f)
+            return std::nullopt;
+        return SweepHit{.t = 0.f, .normal = normal};
+    }
+
+    auto       res      = std::optional<SweepHit>{};
+    auto const consider = [&](float t, glm::vec2 normal) {
+        if (t >= 0.f && t <= 1.f && (!res || t < res->t))
+            res = SweepHit{.t = t, .normal = normal};
+    };
+
+    // Sides
+    if (edge_length > 1e-6f)
+    {
+        auto  normal        = edge_normal;
+        float distance_from = glm::dot(from - segment.a, normal);
+        if (distance_from < 0.f)
+        {
+            normal        = -normal;
+            distance_from = -distance_from;
+        }
+        float const distance_to = glm::dot(from + motion - segment.a, normal);
+        if (distance_to < radius && distance_from > distance_to)
+        {
+            float const t       = (distance_from - radius) / (distance_from - distance_to);
+            auto const  contact = from + t * motion;
+            float const along   = glm::dot(contact - segment.a, edge) / (edge_length * edge_length);
+            if (along >= 0.f && along <= 1.f)
+                consider(t, normal);
+        }
+    }
+
+    // Caps
+    for (auto const& center : {segment.a, segment.b})
+    {
+        auto const  offset = from - center;
+        float const a      = glm::dot(motion, motion);
+        float const b      = glm::dot(offset, motion);
+        float const c      = glm::dot(offset, offset) - radius * radius;
+        float const delta  = b * b - a * c;
+        if (a < 1e-12f || delta < 0.f)
+            continue;
+        float const t = (-b - std::sqrt(delta)) / a;
+        consider(t, glm::normalize(from + t * motion - center));
+    }
+    return res;
+}
+
+LineSoup::LineSoup(std::vector<Segment> segments)
+    : _segments{std::move(segments)}
+{
+    if (_segments.empty())
+        return;
+    _nodes.reserve(2 * _segments.size());
+    _nodes.emplace_back();
+    build(0, 0, _segments.size());
+}
+
+void LineSoup::build(size_t node_index, size_t begin, size_t end)
+{
+    auto box_min = glm::vec2{std::numeric_limits<float>::infinity()};
+    auto box_max = glm::vec2{-std::numeric_limits<float>::infinity()};
+    for (size_t i = begin; i < end; ++i)
+    {
+        box_min = glm::min(box_min, glm::min(_segments[i].a, _segments[i].b));
+        box_max = glm::max(box_max, glm::max(_segments[i].a, _segments[i].b));
+    }
+    _nodes[node_index].min = box_min;
+    _nodes[node_index].max = box_max;
+
+    if (end - begin <= 4)
+    {
+        _nodes[node_index].first = static_cast<uint32_t>(begin);
+        _nodes[node_index].count = static_cast<uint32_t>(end - begin);
+        return;
+    }
+
+    // The geometry is static and usually small, so a median split along the longest axis is good enough
+    int const  axis   = box_max.x - box_min.x >= box_max.y - box_min.y ? 0 : 1;
+    auto const middle = begin + (end - begin) / 2;
+    std::nth_element(_segments.begin() + static_cast<std::ptrdiff_t>(begin), _segments.begin() + static_cast<std::ptrdiff_t>(middle), _segments.begin() + static_cast<std::ptrdiff_t>(end), [&](Segment const& s1, Segment const& s2) {
+        return s1.a[axis] + s1.b[axis] < s2.a[axis] + s2.b[axis];
+    });
+    auto const first_child   = _nodes.size();
+    _nodes[node_index].first = static_cast<uint32_t>(first_child);
+    _nodes[node_index].count = 0;
+    _nodes.emplace_back();
+    _nodes.emplace_back();
+    build(first_child, begin, middle);
+    build(first_child + 1, middle, end);
+}
+
+auto LineSoup::from_mesh_slice(gl::MeshData const& mesh, float z) -> LineSoup
+{
+    auto const members         = gl::internal::vertex_members(mesh.layout);
+    auto const position_member = std::find_if(members.begin(), members.end(), [](gl::VertexMember const& member) {
+        return member.location == 0 && member.type == GL_FLOAT && member.components_count == 3;
+    });
+    if (position_member == members.end())
+        gl::handle_error("[LineSoup] The mesh must have a Position3D at location 0.");
+
+    size_t const offset   = position_member->offset / sizeof(float);
+    size_t const stride   = mesh.floats_per_vertex();
+    auto const   position = [&](uint32_t index) {
+        auto const* p = &mesh.vertices[index * stride + offset];
+        return glm::vec3{p[0], p[1], p[2]};
+    };
+
+    auto segments = std::vector<Segment>{};
+    auto ends     = std::vector<glm::vec2>{};
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        auto const triangle = std::array{position(mesh.indices[i]), position(mesh.indices[i + 1]), position(mesh.indices[i + 2])};
+        // The vertices that are on the plane, and the edges that cross it, give the ends of the segment
+        ends.clear();
+        auto const add_end = [&](glm::vec2 end) {
+            if (std::find(ends.begin(), ends.end(), end) == ends.end())
+                ends.push_back(end);
+        };
+        for (size_t e = 0; e < 3; ++e)
+        {
+            auto const& p1 = triangle[e];
+            auto const& p2 = triangle[(e + 1) % 3];
+            if (p1.z == z)
+                add_end(glm::vec2{p1});
+            else if ((p1.z - z) * (p2.z - z) < 0.f)
+                add_end(glm::vec2{glm::mix(p1, p2, (z - p1.z) / (p2.z - p1.z))});
+        }
+        // A triangle that only touches the plane gives 1 end, and one that lies in the plane gives 3: its edges come from its neighbours
+        if (ends.size() == 2)
+            segments.push_back({ends[0], ends[1]});
+    }
+    return LineSoup{std::move(segments)};
+}
+
+auto LineSoup::sweep(glm::vec2 from, glm::vec2 to, float radius) const -> std::optional<SweepHit>
+{
+    if (_nodes.empty())
+        return std::nullopt;
+
+    auto const motion     = to - from;
+    auto const motion_min = glm::min(from, to) - radius;
+    auto const motion_max = glm::max(from, to) + radius;
+    auto       res        = std::optional<SweepHit>{};
+
+    auto   stack      = std::array<uint32_t, 64>{};
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        auto const& node = _nodes[stack[--stack_size]];
+        if (glm::any(glm::lessThan(node.max, motion_min)) || glm::any(glm::greaterThan(node.min, motion_max)))
+            continue;
+        if (node.count == 0)
+        {
+            stack[stack_size++] = node.first;
+            stack[stack_size++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            auto const hit = sweep_segment(from, motion, radius, _segments[i]);
+            if (hit && (!res || hit->t < res->t))
+                res = hit;
+        }
+    }
+    return res;
+}
+
+void move_and_collide(std::span<Particle> particles, float dt, LineSoup const& geometry, Collide_Options const& options)
+{
+    gl::parallel_for(particles.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& particle  = particles[i];
+            float time_left = dt;
+            // A few iterations, so that a particle that bounces in a corner doesn't end up inside the other wall
+            for (int iteration = 0; iteration < 3 && time_left > 0.f; ++iteration)
+            {
+                auto const target = particle.position + particle.velocity * time_left;
+                auto const hit    = geometry.sweep(particle.position, target, options.radius);
+                if (!hit)
+                {
+                    particle.position = target;
+                    break;
+                }
+                particle.position = glm::mix(particle.position, target, hit->t) + hit->normal * 1e-5f;
+                time_left *= 1.f - hit->t;
+
+                float const normal_speed = glm::dot(particle.velocity, hit->normal);
+                if (normal_speed < 0.f)
+                {
+                    auto const tangential_velocity = particle.velocity - normal_speed * hit->normal;
+                    particle.velocity              = tangential_velocity * (1.f - options.friction) - normal_speed * options.restitution * hit->normal;
+                }
+            }
+        }
+    });
+}
+
+} // namespace collision
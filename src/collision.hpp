@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "opengl-framework/opengl-framework.hpp"
+#include "particle.hpp"
+
+namespace collision {
+
+struct Segment {
+    glm::vec2 a;
+    glm::vec2 b;
+};
+
+struct SweepHit {
+    float     t;      /// Fraction of the motion at which the contact happens, in [0, 1]
+    glm::vec2 normal; /// Points towards the side the particle comes from
+};
+
+/// Static 2D geometry made of line segments, indexed by a bounding volume hierarchy so that a query only looks at the segments near the particle.
+class LineSoup {
+public:
+    explicit LineSoup(std::vector<Segment> segments);
+    /// Cuts the triangles of a 3D mesh with the plane z = `z`. Use it to collide with a .obj mesh loaded with gl::load_mesh_data().
+    static auto from_mesh_slice(gl::MeshData const& mesh, float z = 0.f) -> LineSoup;
+
+    /// Continuous test: the first contact of a disk of radius `radius` moving from `from` to `to`.
+    /// It can't tunnel through thin segments, whatever the speed.
+    auto sweep(glm::vec2 from, glm::vec2 to, float radius) const -> std::optional<SweepHit>;
+
+    auto segments() const -> std::span<Segment const> { return _segments; }
+
+private:
+    struct Node {
+        glm::vec2 min;
+        glm::vec2 max;
+        uint32_t  first; /// First child (the second one is right after it), or first segment of a leaf
+        uint32_t  count; /// Number of segments, 0 for inner nodes
+    };
+    void build(size_t node_index, size_t begin, size_t end);
+
+private:
+    std::vector<Segment> _segments;
+    std::vector<Node>    _nodes{};
+};
+
+struct Collide_Options {
+    float radius{0.01f};
+    float restitution{0.5f}; /// 1 is a perfect bounce, 0 makes the particles slide along the geometry
+    float friction{0.1f};    /// Fraction of the tangential velocity lost at each contact
+};
+
+/// Moves all the particles by velocity * dt, and bounces them off the geometry. The particles are processed in parallel.
+void move_and_collide(std::span<Particle> particles, float dt, LineSoup const&, Collide_Options const& = {});
+
+} // namespace collision
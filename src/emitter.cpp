@@ -0,0 +1,158 @@
+#include "emitter.hpp"
+#include <algorithm>
+#include <cmath>
+#include "bezier.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "poisson_disc.hpp"
+
+namespace {
+
+// Random numbers that each attribute needs, per particle
+enum RandomSlot : size_t {
+    ShapeU,
+    ShapeV,
+    Mass,
+    LifeTime,
+    Speed,
+    Direction,
+    Elapsed,
+    SlotsCount,
+};
+
+void map_to_range(std::span<float const> uniforms, Range range, auto&& set)
+{
+    for (size_t i = 0; i < uniforms.size(); ++i)
+        set(i, range.min + uniforms[i] * (range.max - range.min));
+}
+
+void sample_positions(EmitterShape::Point const& shape, std::span<float const>, std::span<float const>, std::span<glm::vec2 const>, std::span<Particle> particles)
+{
+    for (auto& particle : particles)
+        particle.position = shape.position;
+}
+
+void sample_positions(EmitterShape::Line const& shape, std::span<float const> u, std::span<float const>, std::span<glm::vec2 const>, std::span<Particle> particles)
+{
+    for (size_t i = 0; i < particles.size(); ++i)
+        particles[i].position = glm::mix(shape.start, shape.end, u[i]);
+}
+
+void sample_positions(EmitterShape::Curve const& shape, std::span<float const> u, std::span<float const>, std::span<glm::vec2 const>, std::span<Particle> particles)
+{
+    auto const& p = shape.control_points;
+    for (size_t i = 0; i < particles.size(); ++i)
+        particles[i].position = bezier3_bernstein(p[0], p[1], p[2], p[3], u[i]);
+}
+
+void sample_positions(EmitterShape::Disc const& shape, std::span<float const> u, std::span<float const> v, std::span<glm::vec2 const>, std::span<Particle> particles)
+{
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        float const radius    = shape.radius * std::sqrt(u[i]); // sqrt() makes the density uniform over the area
+        float const angle     = 2.f * glm::pi<float>() * v[i];
+        particles[i].position = shape.center + radius * glm::vec2{std::cos(angle), std::sin(angle)};
+    }
+}
+
+void sample_positions(EmitterShape::Poisson const& shape, std::span<float const> u, std::span<float const>, std::span<glm::vec2 const> poisson_points, std::span<Particle> particles)
+{
+    if (poisson_points.empty())
+    {
+        sample_positions(EmitterShape::Point{shape.min}, u, u, poisson_points, particles);
+        return;
+    }
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        auto const index      = std::min(static_cast<size_t>(u[i] * static_cast<float>(poisson_points.size())), poisson_points.size() - 1);
+        particles[i].position = poisson_points[index];
+    }
+}
+
+} // namespace
+
+Emitter::Emitter(Emitter_Descriptor const& desc)
+    : _desc{desc}
+    , _time_until_burst{desc.burst_interval}
+    , _random_stream{desc.seed}
+{
+    set_shape(desc.shape);
+}
+
+void Emitter::set_shape(AnyEmitterShape const& shape)
+{
+    _desc.shape = shape;
+    _poisson_points.clear();
+    if (auto const* poisson = std::get_if<EmitterShape::Poisson>(&shape))
+    {
+        _poisson_points = PoissonDisc::GeneratePoints(poisson->radius, poisson->size);
+        for (auto& point : _poisson_points)
+            point += poisson->min;
+    }
+}
+
+auto Emitter::advance(float dt) -> size_t
+{
+    _rate_accumulator += _desc.rate * dt;
+    auto const from_rate = static_cast<size_t>(_rate_accumulator);
+    _rate_accumulator -= static_cast<float>(from_rate); // Keep the fractional part, so that low rates still spawn particles from time to time
+
+    if (_desc.burst_interval > 0.f)
+    {
+        _time_until_burst -= dt;
+        while (_time_until_burst <= 0.f)
+        {
+            _pending_burst += _desc.burst_count;
+            _time_until_burst += _desc.burst_interval;
+        }
+    }
+
+    size_t const count = from_rate + _pending_burst;
+    _pending_burst     = 0;
+    return count;
+}
+
+void Emitter::emit(std::span<Particle> particles)
+{
+    size_t const count = particles.size();
+    _random.resize(SlotsCount * count);
+    _random_stream.fill_uniform(_random, 0.f, 1.f);
+    auto const uniforms = [&](RandomSlot slot) {
+        return std::span<float const>{_random}.subspan(slot * count, count);
+    };
+
+    std::visit([&](auto&& shape) { sample_positions(shape, uniforms(ShapeU), uniforms(ShapeV), _poisson_points, particles); }, _desc.shape);
+    map_to_range(uniforms(Mass), _desc.mass, [&](size_t i, float mass) { particles[i].mass = mass; });
+    map_to_range(uniforms(LifeTime), _desc.life_time, [&](size_t i, float life_time) { particles[i].life_time = life_time; });
+    map_to_range(uniforms(Elapsed), _desc.elapsed, [&](size_t i, float elapsed) { particles[i].elapsed = elapsed; });
+    map_to_range(uniforms(Speed), _desc.speed, [&](size_t i, float speed) { particles[i].velocity = glm::vec2{speed}; });
+    map_to_range(uniforms(Direction), _desc.direction, [&](size_t i, float angle) { particles[i].velocity *= glm::vec2{std::cos(angle), std::sin(angle)}; });
+    for (auto& particle : particles)
+    {
+        particle.previous_position = particle.position;
+        particle.age               = 0.f;
+    }
+}
+
+void emit_particles(std::span<Emitter> emitters, ParticlePool& pool, float dt)
+{
+    auto counts = std::vector<size_t>(emitters.size());
+    for (size_t i = 0; i < emitters.size(); ++i)
+        counts[i] = emitters[i].advance(dt);
+
+    size_t const available = pool.free_count();
+    size_t       total     = 0;
+    for (auto& count : counts)
+    {
+        count = std::min(count, available - total);
+        total += count;
+    }
+
+    auto const particles = pool.spawn(total);
+    auto       offsets   = std::vector<size_t>(emitters.size() + 1, 0);
+    for (size_t i = 0; i < emitters.size(); ++i)
+        offsets[i + 1] = offsets[i] + counts[i];
+    gl::parallel_for(emitters.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            emitters[i].emit(particles.subspan(offsets[i], counts[i]));
+    });
+}
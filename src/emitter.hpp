@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <variant>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include "particle.hpp"
+#include "particle_pool.hpp"
+#include "rng.hpp"
+
+namespace EmitterShape {
+struct Point {
+    glm::vec2 position{};
+};
+struct Line {
+    glm::vec2 start{};
+    glm::vec2 end{};
+};
+/// A cubic Bézier curve. The particles are spread uniformly in t, not in arc length.
+struct Curve {
+    std::array<glm::vec2, 4> control_points{};
+};
+struct Disc {
+    glm::vec2 center{};
+    float     radius{1.f};
+};
+/// A rectangle covered with points that are all at least `radius` apart (see PoissonDisc::GeneratePoints()). The points are generated once, and each particle spawns on one of them.
+struct Poisson {
+    glm::vec2 min{};
+    glm::vec2 size{1.f};
+    float     radius{0.05f};
+};
+} // namespace EmitterShape
+
+using AnyEmitterShape = std::variant<
+    EmitterShape::Point,
+    EmitterShape::Line,
+    EmitterShape::Curve,
+    EmitterShape::Disc,
+    EmitterShape::Poisson>;
+
+/// Uniform distribution between min and max
+struct Range {
+    float min{};
+    float max{};
+};
+
+struct Emitter_Descriptor {
+    AnyEmitterShape shape{EmitterShape::Point{}};
+    float           rate{0.f};           /// Particles per second
+    float           burst_interval{0.f}; /// Seconds between two automatic bursts. 0 means no automatic bursts, but you can still call burst() yourself.
+    uint32_t        burst_count{0};      /// Number of particles of each automatic burst
+    Range           mass{1.f, 1.f};
+    Range           life_time{2.f, 5.f};
+    Range           speed{0.f, 0.f};
+    Range           direction{0.f, 2.f * glm::pi<float>()}; /// Angle of the initial velocity, in radians
+    Range           elapsed{0.f, 1.f};
+    uint64_t        seed{0}; /// Id of the rng::Stream of the emitter, combined with rng::global_seed(). Give a different one to each emitter, otherwise they spawn the same particles.
+};
+
+/// Spawns particles on a shape, at a constant rate and / or in bursts.
+/// All the attributes of a batch of particles are generated in one go: the emitter fills arrays of random numbers with rng::Stream::fill_uniform(), and then maps them to each attribute with a loop that doesn't branch on the shape.
+class Emitter {
+public:
+    explicit Emitter(Emitter_Descriptor const&);
+
+    /// Spawns `count` more particles the next time that advance() is called
+    void burst(uint32_t count) { _pending_burst += count; }
+
+    /// Advances the emitter by `dt` seconds, and returns the number of particles that it wants to spawn now
+    auto advance(float dt) -> size_t;
+    /// Initializes all the particles of the span
+    void emit(std::span<Particle> particles);
+
+    auto descriptor() const -> Emitter_Descriptor const& { return _desc; }
+    void set_shape(AnyEmitterShape const&);
+
+private:
+    Emitter_Descriptor     _desc;
+    std::vector<glm::vec2> _poisson_points{}; /// Only used by EmitterShape::Poisson
+    float                  _rate_accumulator{0.f};
+    float                  _time_until_burst{0.f};
+    uint32_t               _pending_burst{0};
+    rng::Stream            _random_stream;
+    std::vector<float>     _random{};
+};
+
+/// Advances all the emitters, and spawns their particles into the pool. The emitters fill their particles in parallel.
+/// When the pool is full, the particles that don't fit are dropped (the first emitters get served first).
+void emit_particles(std::span<Emitter> emitters, ParticlePool& pool, float dt);
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace morton {
+
+/// Spreads the 16 lower bits of x so that there is a 0 between each of them
+inline uint32_t part_1_by_1(uint32_t x)
+{
+    x &= 0x0000ffff;
+    x = (x | (x << 8)) & 0x00ff00ff;
+    x = (x | (x << 4)) & 0x0f0f0f0f;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+/// Inverse of part_1_by_1(): gathers the even bits of x
+inline uint32_t compact_1_by_1(uint32_t x)
+{
+    x &= 0x55555555;
+    x = (x | (x >> 1)) & 0x33333333;
+    x = (x | (x >> 2)) & 0x0f0f0f0f;
+    x = (x | (x >> 4)) & 0x00ff00ff;
+    x = (x | (x >> 8)) & 0x0000ffff;
+    return x;
+}
+
+/// Z-order curve: interleaves the bits of x and y (16 bits each), so that points that are close in 2D usually get close codes.
+/// The 2 highest bits give the quadrant of the point, the next 2 its quadrant inside that quadrant, and so on.
+inline uint32_t encode(uint32_t x, uint32_t y)
+{
+    return (part_1_by_1(y) << 1) | part_1_by_1(x);
+}
+
+/// Quantizes `position` to a 16-bit grid over the square [min, min + size]
+inline uint32_t encode(glm::vec2 position, glm::vec2 min, float size)
+{
+    auto const normalized = glm::clamp((position - min) / size, 0.f, 1.f);
+    auto const quantized  = glm::uvec2{normalized * 65535.f};
+    return encode(quantized.x, quantized.y);
+}
+
+} // namespace morton
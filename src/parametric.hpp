@@ -0,0 +1,18 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// Evaluates the curve `p` at segments + 1 evenly spaced values of t, from 0 to 1
+inline std::vector<glm::vec2> sample_parametric(std::function<glm::vec2(float)> const& p,
+                                                int segments)
+{
+    std::vector<glm::vec2> points;
+    points.reserve(static_cast<size_t>(segments) + 1);
+    points.push_back(p(0.f));
+    for (int i = 1; i <= segments; ++i) {
+        float t = float(i)/float(segments);
+        points.push_back(p(t));
+    }
+    return points;
+}
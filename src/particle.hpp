@@ -0,0 +1,12 @@
+#pragma once
+#include <glm/glm.hpp>
+
+struct Particle {
+    glm::vec2 position;
+    glm::vec2 previous_position; // Position at the previous simulation step, to interpolate between the two when rendering
+    glm::vec2 velocity;
+    float     elapsed;
+    float     mass;
+    float     age;
+    float     life_time;
+};
@@ -0,0 +1,65 @@
+#include "particle_pool.hpp"
+#include <algorithm>
+#include <numeric>
+#include "opengl-framework/opengl-framework.hpp"
+
+static constexpr size_t block_size = 4096;
+
+ParticlePool::ParticlePool(size_t capacity)
+    : _capacity{capacity}
+{
+    _particles.reserve(capacity);
+    _compacted.reserve(capacity);
+    _dead.reserve(capacity);
+    _block_offsets.reserve(capacity / block_size + 2);
+}
+
+auto ParticlePool::remove_dead(Lifecycle_Options const& options) -> size_t
+{
+    size_t const count        = _particles.size();
+    size_t const blocks_count = (count + block_size - 1) / block_size;
+    _dead.resize(count);
+    _block_offsets.assign(blocks_count + 1, 0);
+
+    // Flag the dead particles, and count the alive ones in each block
+    gl::parallel_for(blocks_count, 1, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block)
+        {
+            size_t alive_count = 0;
+            for (size_t i = block * block_size; i < std::min((block + 1) * block_size, count); ++i)
+            {
+                _dead[i] = is_dead(_particles[i], options) ? 1 : 0;
+                if (!_dead[i])
+                    alive_count++;
+            }
+            _block_offsets[block + 1] = alive_count;
+        }
+    });
+    std::partial_sum(_block_offsets.begin(), _block_offsets.end(), _block_offsets.begin());
+
+    size_t const alive_count = _block_offsets.back();
+    if (alive_count == count)
+        return 0;
+
+    _compacted.resize(alive_count);
+    gl::parallel_for(blocks_count, 1, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block)
+        {
+            size_t destination = _block_offsets[block];
+            for (size_t i = block * block_size; i < std::min((block + 1) * block_size, count); ++i)
+            {
+                if (!_dead[i])
+                    _compacted[destination++] = _particles[i];
+            }
+        }
+    });
+    _particles.swap(_compacted);
+    return count - alive_count;
+}
+
+auto ParticlePool::spawn(size_t count) -> std::span<Particle>
+{
+    size_t const first = _particles.size();
+    _particles.resize(first + std::min(count, free_count()));
+    return std::span{_particles}.subspan(first);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "particle.hpp"
+
+struct Lifecycle_Options {
+    float kill_below_y{-1.1f}; /// Particles that fall below this height die, even if they haven't reached their life_time yet
+};
+
+/// A particle dies when it gets older than its life_time, or when it leaves the screen
+inline bool is_dead(Particle const& particle, Lifecycle_Options const& options)
+{
+    return particle.age >= particle.life_time || particle.position.y < options.kill_below_y;
+}
+
+/// Storage for a variable number of particles, that never reallocates: all the memory is reserved for `capacity` particles upfront.
+/// Each step, the dead particles are removed in one go by remove_dead(), and new ones are added in one go by spawn(), so that the update of the particles doesn't have to deal with any of that.
+class ParticlePool {
+public:
+    explicit ParticlePool(size_t capacity);
+
+    /// The particles that are alive. You can reorder them (e.g. with ParticleSorter), but you shouldn't add or remove any yourself.
+    auto particles() -> std::vector<Particle>& { return _particles; }
+    auto particles() const -> std::vector<Particle> const& { return _particles; }
+    auto size() const -> size_t { return _particles.size(); }
+    auto capacity() const -> size_t { return _capacity; }
+    auto free_count() const -> size_t { return _capacity - _particles.size(); }
+
+    /// Flags the dead particles, and compacts the alive ones in parallel (with a prefix sum over blocks of particles). The order of the alive particles is kept, so a Morton sort stays valid.
+    /// Returns the number of particles that have been removed.
+    auto remove_dead(Lifecycle_Options const& = {}) -> size_t;
+
+    /// Appends `count` particles (or as many as there are free slots), and returns them so that you can initialize them.
+    auto spawn(size_t count) -> std::span<Particle>;
+
+private:
+    size_t                _capacity;
+    std::vector<Particle> _particles{};
+    std::vector<Particle> _compacted{};     /// Destination of the compaction, swapped with _particles afterwards
+    std::vector<uint8_t>  _dead{};          /// One flag per particle
+    std::vector<size_t>   _block_offsets{}; /// Where each block writes its alive particles
+};
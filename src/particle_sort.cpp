@@ -0,0 +1,69 @@
+#include "particle_sort.hpp"
+#include <algorithm>
+#include <numeric>
+#include "morton.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "radix_sort.hpp"
+
+auto ParticleSorter::locality(std::span<Particle const> particles) -> float
+{
+    if (particles.size() < 2)
+        return 0.f;
+    double sum = 0.;
+    for (size_t i = 1; i < particles.size(); ++i)
+        sum += glm::distance(particles[i - 1].position, particles[i].position);
+    return static_cast<float>(sum / static_cast<double>(particles.size() - 1));
+}
+
+auto ParticleSorter::update(std::vector<Particle>& particles) -> bool
+{
+    _frames_since_sort++;
+    bool const must_sort = !_has_sorted
+                           || _frames_since_sort >= _options.frames_between_sorts
+                           || locality(particles) > _locality_after_sort * _options.locality_degradation;
+    if (must_sort)
+        sort(particles);
+    return must_sort;
+}
+
+void ParticleSorter::sort(std::vector<Particle>& particles)
+{
+    size_t const count = particles.size();
+    _frames_since_sort = 0;
+    _has_sorted        = true;
+    if (count == 0)
+        return;
+
+    auto min = particles[0].position;
+    auto max = particles[0].position;
+    for (auto const& particle : particles)
+    {
+        min = glm::min(min, particle.position);
+        max = glm::max(max, particle.position);
+    }
+    float const size = std::max({max.x - min.x, max.y - min.y, 1e-6f});
+
+    _codes.resize(count);
+    _order.resize(count);
+    gl::parallel_for(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            _codes[i] = morton::encode(particles[i].position, min, size);
+            _order[i] = static_cast<uint32_t>(i);
+        }
+    });
+    radix_sort(_codes, _order);
+
+    _sorted.reserve(particles.capacity()); // We swap the two vectors, so keep the capacity that the caller has reserved
+    _sorted.resize(count);
+    _new_index.resize(count);
+    gl::parallel_for(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            _sorted[i]            = particles[_order[i]];
+            _new_index[_order[i]] = static_cast<uint32_t>(i);
+        }
+    });
+    particles.swap(_sorted);
+    _locality_after_sort = locality(particles);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "particle.hpp"
+
+struct ParticleSort_Options {
+    int   frames_between_sorts{120};    /// Sort at least this often
+    float locality_degradation{1.5f};     /// Also sort as soon as locality() becomes this much worse than right after the previous sort
+};
+
+/// Keeps the particles sorted along a Z-order curve, so that particles that are close in space are also close in memory, and the spatial passes (grids, trees) get coherent memory accesses.
+/// The particles move, so the order degrades over time: update() must be called once per frame, and re-sorts them when needed.
+class ParticleSorter {
+public:
+    explicit ParticleSorter(ParticleSort_Options const& options = {})
+        : _options{options}
+    {}
+
+    /// Returns true if the particles have been reordered during this call. Use new_index() to update the indices that you might store somewhere else.
+    auto update(std::vector<Particle>& particles) -> bool;
+    void sort(std::vector<Particle>& particles);
+
+    /// new_index()[i] is the index where the particle that was at index i before the last sort now is
+    auto new_index() const -> std::span<uint32_t const> { return _new_index; }
+
+    /// Average distance between particles that are next to each other in memory. The lower the better.
+    static auto locality(std::span<Particle const> particles) -> float;
+
+private:
+    ParticleSort_Options  _options;
+    int                   _frames_since_sort{0};
+    float                 _locality_after_sort{0.f};
+    bool                  _has_sorted{false};
+    std::vector<uint32_t> _codes{};
+    std::vector<uint32_t> _order{};
+    std::vector<uint32_t> _new_index{};
+    std::vector<Particle> _sorted{};
+};
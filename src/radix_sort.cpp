@@ -0,0 +1,67 @@
+#include "radix_sort.hpp"
+#include <array>
+#include <cassert>
+#include "opengl-framework/opengl-framework.hpp"
+
+void radix_sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values)
+{
+    assert(keys.size() == values.size());
+    size_t const count = keys.size();
+    if (count < 2)
+        return;
+
+    constexpr size_t radix        = 256;
+    size_t const     block_size   = std::max<size_t>(count / (4 * gl::threads_count()), 4096);
+    size_t const     blocks_count = (count + block_size - 1) / block_size;
+
+    auto keys_tmp   = std::vector<uint32_t>(count);
+    auto values_tmp = std::vector<uint32_t>(count);
+    auto histograms = std::vector<std::array<size_t, radix>>(blocks_count); /// Becomes the offset where each block writes each digit
+
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        gl::parallel_for(blocks_count, 1, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block)
+            {
+                auto& histogram = histograms[block];
+                histogram.fill(0);
+                for (size_t i = block * block_size; i < std::min((block + 1) * block_size, count); ++i)
+                    histogram[(keys[i] >> shift) & 0xff]++;
+            }
+        });
+
+        // Digit-major prefix sum, so that the order of the keys that have the same digit is kept
+        size_t offset = 0;
+        bool   skip   = false;
+        for (size_t digit = 0; digit < radix; ++digit)
+        {
+            size_t digit_count = 0;
+            for (auto& histogram : histograms)
+            {
+                size_t const block_count = histogram[digit];
+                histogram[digit]         = offset;
+                offset += block_count;
+                digit_count += block_count;
+            }
+            if (digit_count == count)
+                skip = true; // All the keys have this digit, this pass would not change anything
+        }
+        if (skip)
+            continue;
+
+        gl::parallel_for(blocks_count, 1, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block)
+            {
+                auto& histogram = histograms[block];
+                for (size_t i = block * block_size; i < std::min((block + 1) * block_size, count); ++i)
+                {
+                    size_t const destination = histogram[(keys[i] >> shift) & 0xff]++;
+                    keys_tmp[destination]    = keys[i];
+                    values_tmp[destination]  = values[i];
+                }
+            }
+        });
+        keys.swap(keys_tmp);
+        values.swap(values_tmp);
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// Sorts `keys` in increasing order, and applies the same permutation to `values`. The sort is stable.
+/// LSD radix sort, 8 bits per pass, where each pass is run in parallel: every thread counts the digits of its block of keys, then scatters them at the offsets given by a prefix sum over all the blocks.
+/// Passes where all the keys have the same digit are skipped, so keys that only use their low bits are cheap to sort.
+void radix_sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values);
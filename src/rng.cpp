@@ -0,0 +1,196 @@
+#include "rng.hpp"
+#include <atomic>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RNG_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace rng {
+
+namespace {
+
+constexpr uint32_t multiplier_0 = 0xD2511F53;
+constexpr uint32_t multiplier_1 = 0xCD9E8D57;
+constexpr uint32_t weyl_0       = 0x9E3779B9;
+constexpr uint32_t weyl_1       = 0xBB67AE85;
+
+std::atomic<uint64_t> g_seed{0x853c49e6748fea9b};  // NOLINT(*avoid-non-const-global-variables)
+std::atomic<uint64_t> g_next_thread_stream{0};     // NOLINT(*avoid-non-const-global-variables)
+constexpr uint64_t    threads_parent_stream{~0ull}; // Streams returned by thread_stream() are derived from this one
+
+auto splitmix64(uint64_t x) -> uint64_t
+{
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+auto to_unit_float(uint32_t bits) -> float
+{
+    return static_cast<float>(bits >> 8) * 0x1p-24f; // 24 bits, the precision of a float
+}
+
+auto make_counter(uint64_t block, uint64_t stream_id) -> Counter
+{
+    return {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), static_cast<uint32_t>(stream_id), static_cast<uint32_t>(stream_id >> 32)};
+}
+
+auto make_key(uint64_t seed) -> Key
+{
+    return {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+}
+
+#if RNG_USE_SSE2
+/// 32x32 -> 64 bits multiplication of the 4 lanes of `a` by `b`
+void mulhilo(__m128i a, __m128i b, __m128i& hi, __m128i& lo)
+{
+    __m128i const even    = _mm_mul_epu32(a, b);                     // Products of lanes 0 and 2
+    __m128i const odd     = _mm_mul_epu32(_mm_srli_epi64(a, 32), b); // Products of lanes 1 and 3
+    __m128i const low_32s = _mm_set_epi32(0, -1, 0, -1);
+    lo                    = _mm_or_si128(_mm_and_si128(even, low_32s), _mm_slli_epi64(odd, 32));
+    hi                    = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low_32s, odd));
+}
+
+/// The 4 words of 4 blocks: lane j of word w is the w-th word of the j-th block
+struct Blocks_x4 {
+    __m128i words[4]; // NOLINT(*c-arrays)
+};
+
+/// Runs Philox on 4 consecutive blocks at once
+void philox4x32_x4(Blocks_x4& c, Key key)
+{
+    __m128i const m0 = _mm_set1_epi32(static_cast<int>(multiplier_0));
+    __m128i const m1 = _mm_set1_epi32(static_cast<int>(multiplier_1));
+    for (int round = 0; round < 10; ++round)
+    {
+        __m128i hi0, lo0, hi1, lo1; // NOLINT(*init-variables)
+        mulhilo(c.words[0], m0, hi0, lo0);
+        mulhilo(c.words[2], m1, hi1, lo1);
+        __m128i const k0 = _mm_set1_epi32(static_cast<int>(key[0]));
+        __m128i const k1 = _mm_set1_epi32(static_cast<int>(key[1]));
+        c.words[0]       = _mm_xor_si128(_mm_xor_si128(hi1, c.words[1]), k0);
+        c.words[1]       = lo1;
+        c.words[2]       = _mm_xor_si128(_mm_xor_si128(hi0, c.words[3]), k1);
+        c.words[3]       = lo0;
+        key[0] += weyl_0;
+        key[1] += weyl_1;
+    }
+}
+#endif
+
+} // namespace
+
+auto philox4x32(Counter c, Key key) -> Counter
+{
+    for (int round = 0; round < 10; ++round)
+    {
+        uint64_t const product_0 = uint64_t{multiplier_0} * c[0];
+        uint64_t const product_1 = uint64_t{multiplier_1} * c[2];
+        c                        = {
+            static_cast<uint32_t>(product_1 >> 32) ^ c[1] ^ key[0],
+            static_cast<uint32_t>(product_1),
+            static_cast<uint32_t>(product_0 >> 32) ^ c[3] ^ key[1],
+            static_cast<uint32_t>(product_0),
+        };
+        key[0] += weyl_0;
+        key[1] += weyl_1;
+    }
+    return c;
+}
+
+void set_global_seed(uint64_t seed)
+{
+    g_seed.store(seed);
+}
+
+auto global_seed() -> uint64_t
+{
+    return g_seed.load();
+}
+
+auto derive_stream_id(uint64_t parent, uint64_t index) -> uint64_t
+{
+    return splitmix64(splitmix64(parent) ^ index);
+}
+
+Stream::Stream(uint64_t stream_id, uint64_t seed)
+    : _key{make_key(seed)}
+    , _counter{make_counter(0, stream_id)}
+{}
+
+void Stream::refill()
+{
+    _block          = philox4x32(_counter, _key);
+    _block_position = 0;
+    if (++_counter[0] == 0)
+        ++_counter[1];
+}
+
+auto Stream::next_uint() -> uint32_t
+{
+    if (_block_position == 4)
+        refill();
+    return _block[_block_position++];
+}
+
+auto Stream::uniform(float min, float max) -> float
+{
+    return min + to_unit_float(next_uint()) * (max - min);
+}
+
+void Stream::fill_uniform(std::span<float> values, float min, float max)
+{
+    size_t i = 0;
+    // Use what is left of the current block first, so that the sequence is the same as with uniform()
+    for (; i < values.size() && _block_position < 4; ++i)
+        values[i] = uniform(min, max);
+
+#if RNG_USE_SSE2
+    __m128 const scale  = _mm_set1_ps((max - min) * 0x1p-24f);
+    __m128 const offset = _mm_set1_ps(min);
+    for (; i + 16 <= values.size(); i += 16)
+    {
+        if (_counter[0] > UINT32_MAX - 4) // The 4 blocks would wrap around the low word of the counter, let the scalar path handle that
+            break;
+        auto c = Blocks_x4{{
+            _mm_add_epi32(_mm_set1_epi32(static_cast<int>(_counter[0])), _mm_set_epi32(3, 2, 1, 0)),
+            _mm_set1_epi32(static_cast<int>(_counter[1])),
+            _mm_set1_epi32(static_cast<int>(_counter[2])),
+            _mm_set1_epi32(static_cast<int>(_counter[3])),
+        }};
+        _counter[0] += 4;
+        philox4x32_x4(c, _key);
+
+        auto const to_floats = [&](__m128i word) {
+            return _mm_add_ps(offset, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(word, 8)), scale));
+        };
+        __m128 block_0 = to_floats(c.words[0]);
+        __m128 block_1 = to_floats(c.words[1]);
+        __m128 block_2 = to_floats(c.words[2]);
+        __m128 block_3 = to_floats(c.words[3]);
+        // The blocks must be written one after the other
+        _MM_TRANSPOSE4_PS(block_0, block_1, block_2, block_3);
+        _mm_storeu_ps(values.data() + i, block_0);
+        _mm_storeu_ps(values.data() + i + 4, block_1);
+        _mm_storeu_ps(values.data() + i + 8, block_2);
+        _mm_storeu_ps(values.data() + i + 12, block_3);
+    }
+#endif
+
+    for (; i < values.size(); ++i)
+        values[i] = uniform(min, max);
+}
+
+auto thread_stream() -> Stream&
+{
+    thread_local auto stream = Stream{derive_stream_id(threads_parent_stream, g_next_thread_stream.fetch_add(1))};
+    return stream;
+}
+
+auto uniform_at(uint64_t stream_id, uint64_t index) -> float
+{
+    return to_unit_float(philox4x32(make_counter(index / 4, stream_id), make_key(global_seed()))[index % 4]);
+}
+
+} // namespace rng
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+
+/// Counter-based random numbers: Philox4x32-10 (Salmon, Moraes, Dror and Shaw, "Parallel Random Numbers: As Easy as 1, 2, 3", 2011).
+/// The n-th block of 4 numbers of a stream is a pure function of (seed, stream id, n), so any thread can jump anywhere in any stream for free, and runs are reproducible for a given seed.
+namespace rng {
+
+using Counter = std::array<uint32_t, 4>;
+using Key     = std::array<uint32_t, 2>;
+
+auto philox4x32(Counter, Key) -> Counter;
+
+/// The seed of all the streams that are created afterwards. Set it at the start of the program to get deterministic runs.
+void set_global_seed(uint64_t);
+auto global_seed() -> uint64_t;
+
+/// Id of a sub-stream of `parent`, e.g. one per thread or one per particle. Different (parent, index) pairs give independent streams.
+auto derive_stream_id(uint64_t parent, uint64_t index) -> uint64_t;
+
+class Stream {
+public:
+    explicit Stream(uint64_t stream_id, uint64_t seed = global_seed());
+
+    auto next_uint() -> uint32_t;
+    /// Uniform in [min, max)
+    auto uniform(float min, float max) -> float;
+    /// Same numbers as calling uniform() values.size() times, but 4 blocks are generated at once with SSE2 when it is available
+    void fill_uniform(std::span<float> values, float min, float max);
+
+private:
+    void refill();
+
+private:
+    Key      _key;
+    Counter  _counter; /// Index of the next block in [0] and [1], stream id in [2] and [3]
+    Counter  _block{};
+    uint32_t _block_position{4}; /// Index of the next unused number in _block
+};
+
+/// A stream for the calling thread, derived from the global seed at its first use
+auto thread_stream() -> Stream&;
+
+/// Stateless version, for when each particle (or each anything) needs its own numbers: the `index`-th number in [0, 1) of stream `stream_id`
+auto uniform_at(uint64_t stream_id, uint64_t index) -> float;
+
+} // namespace rng
@@ -0,0 +1,91 @@
+#include "simulation.hpp"
+#include <algorithm>
+#include <span>
+#include "bezier.hpp"
+
+static auto make_emitters(Simulation_Options const& options) -> std::vector<Emitter>
+{
+    float const ar = options.aspect_ratio;
+    return {
+        // Rains from the top of the screen, fast enough to keep the pool roughly full
+        Emitter{{
+            .shape     = EmitterShape::Line{{-ar, 1.1f}, {ar, 1.1f}},
+            .rate      = static_cast<float>(options.particles_count) / 3.5f, // 3.5 seconds is the average life_time
+            .mass      = {0.5f, 2.0f},
+            .life_time = {2.f, 5.f},
+            .seed      = 1,
+        }},
+        // Regular puffs from the bottom left corner
+        Emitter{{
+            .shape          = EmitterShape::Disc{{-0.8f * ar, -0.7f}, 0.05f},
+            .burst_interval = 1.5f,
+            .burst_count    = static_cast<uint32_t>(std::max<size_t>(options.particles_count / 20, 1)),
+            .mass           = {0.5f, 1.0f},
+            .life_time      = {1.f, 2.f},
+            .speed          = {0.5f, 1.2f},
+            .direction      = {0.9f, 1.4f},
+            .seed           = 2,
+        }},
+    };
+}
+
+// A funnel: the particles slide down the ramps, and fall through the gap in the middle
+static auto make_geometry(float ar) -> collision::LineSoup
+{
+    return collision::LineSoup{{
+        {{-ar, -0.4f}, {-0.08f, -0.8f}},
+        {{ar, -0.4f}, {0.08f, -0.8f}},
+    }};
+}
+
+Simulation::Simulation(Simulation_Options const& options)
+    : _options{options}
+    , _pool{options.particles_count}
+    , _emitters{make_emitters(options)}
+    , _geometry{make_geometry(options.aspect_ratio)}
+    , _neighbors{2.f * options.particle_radius}
+    , _accelerations(options.particles_count)
+{
+    _emitters[0].burst(static_cast<uint32_t>(options.particles_count));
+    emit_particles(_emitters, _pool, 0.f);
+}
+
+void Simulation::step(float dt, std::array<glm::vec2, 4> const& curve)
+{
+    auto&       particles         = _pool.particles();
+    float const separation_radius = 2.f * _options.particle_radius;
+
+    _sorter.update(particles);
+    _neighbors.build(particles.size(), [&](size_t i) { return particles[i].position; });
+    if (_options.n_body)
+    {
+        _quadtree.build(particles, _options.n_body_gravity.leaf_size);
+        compute_gravity(_quadtree, particles, std::span{_accelerations}.first(particles.size()), _options.n_body_gravity);
+    }
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        auto& pt             = particles[i];
+        pt.previous_position = pt.position;
+        pt.age += dt;
+        pt.elapsed += dt;
+        pt.velocity += _options.gravity * dt;
+        if (_options.n_body)
+            pt.velocity += _accelerations[i] * dt;
+        _neighbors.for_each_neighbor(pt.position, separation_radius, [&](uint32_t, glm::vec2 other) {
+            glm::vec2 const away = pt.position - other;
+            float const     d    = glm::length(away);
+            if (d > 1e-5f)
+                pt.velocity += away / d * _options.separation_force * (1.f - d / separation_radius) * dt;
+        });
+        float const     t_closest = findClosestT(curve[0], curve[1], curve[2], curve[3], pt.position);
+        glm::vec2 const diff      = pt.position - bezier3_bernstein(curve[0], curve[1], curve[2], curve[3], t_closest);
+        float const     d         = glm::length(diff);
+        if (d < _options.curve_influence_radius && d > 1e-4f)
+            pt.velocity += diff / d * _options.curve_force * (1.f - d / _options.curve_influence_radius) * dt;
+    }
+    collision::move_and_collide(particles, dt, _geometry, {.radius = _options.particle_radius});
+
+    // The dead particles are removed, and new ones are spawned, all at once at the end of the step
+    _pool.remove_dead(_options.lifecycle);
+    emit_particles(_emitters, _pool, dt);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+#include "barnes_hut.hpp"
+#include "collision.hpp"
+#include "emitter.hpp"
+#include "particle.hpp"
+#include "particle_pool.hpp"
+#include "particle_sort.hpp"
+#include "spatial_hash.hpp"
+
+struct Simulation_Options {
+    size_t            particles_count{800};
+    float             aspect_ratio{16.f / 9.f}; /// Width of the scene, the height always goes from -1 to 1
+    glm::vec2         gravity{0.f, -0.5f};
+    float             curve_influence_radius{0.1f}; /// The Bézier curve pushes the particles that are closer than this
+    float             curve_force{25.f};
+    float             particle_radius{0.02f};
+    float             separation_force{2.f}; /// Pushes apart the particles that are closer than 2 * particle_radius
+    bool              n_body{true};          /// The particles attract each other according to their mass
+    Gravity_Options   n_body_gravity{.gravitational_constant = 0.0002f, .softening = 0.05f, .theta = 0.6f};
+    Lifecycle_Options lifecycle{.kill_below_y = -1.1f};
+};
+
+/// Everything that happens to the particles, without any rendering, so that it can also run headless (see benchmarks/particles.cpp)
+class Simulation {
+public:
+    explicit Simulation(Simulation_Options const& = {});
+
+    /// Advances the simulation by `dt` seconds. The particles are pushed away from the cubic Bézier curve defined by the 4 control points.
+    void step(float dt, std::array<glm::vec2, 4> const& curve);
+
+    auto particles() const -> std::vector<Particle> const& { return _pool.particles(); }
+    auto geometry() const -> collision::LineSoup const& { return _geometry; }
+    auto options() const -> Simulation_Options const& { return _options; }
+
+private:
+    Simulation_Options     _options;
+    ParticlePool           _pool;
+    std::vector<Emitter>   _emitters;
+    collision::LineSoup    _geometry;
+    ParticleSorter         _sorter{}; /// Keeps the particles in Z-order, so that the neighbor and gravity queries read memory that is already in cache
+    SpatialHash2D          _neighbors;
+    Quadtree               _quadtree{};
+    std::vector<glm::vec2> _accelerations{};
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "opengl-framework/opengl-framework.hpp"
+
+/// Uniform grid over an unbounded 2D or 3D space: each cell is hashed into a fixed-size table, so that only the cells that contain points use memory.
+/// It is rebuilt from scratch every frame with a counting sort, which is faster than updating it when all the points move.
+/// Usage:
+///     grid.build(particles.size(), [&](size_t i) { return particles[i].position; });
+///     grid.for_each_neighbor(position, radius, [&](uint32_t index, glm::vec2 neighbor_position) { ... });
+template<glm::length_t Dimension>
+class SpatialHash {
+public:
+    using Vec  = glm::vec<Dimension, float>;
+    using IVec = glm::vec<Dimension, int>;
+
+    explicit SpatialHash(float cell_size)
+        : _cell_size{cell_size}
+    {}
+
+    /// `position_of(i)` must return the position of point i, for i in [0, count). It is called from several threads.
+    template<typename PositionOf>
+    void build(size_t count, PositionOf&& position_of)
+    {
+        // Twice as many buckets as points keeps the collisions rare
+        size_t const table_size = std::bit_ceil(std::max<size_t>(2 * count, 64));
+        _table_mask             = static_cast<uint32_t>(table_size - 1);
+        _buckets.resize(count);
+        _sorted_indices.resize(count);
+        _sorted_positions.resize(count);
+        _bucket_start.assign(table_size + 1, 0);
+
+        // Count the points in each bucket
+        gl::parallel_for(count, 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                _buckets[i] = bucket(cell(position_of(i)));
+                std::atomic_ref{_bucket_start[_buckets[i] + 1]}.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        // Exclusive prefix sum: where each bucket starts in the sorted arrays
+        for (size_t i = 1; i <= table_size; ++i)
+            _bucket_start[i] += _bucket_start[i - 1];
+
+        // Scatter. The order inside a bucket depends on the threads, but the neighbor queries don't care.
+        _bucket_fill.assign(_bucket_start.begin(), _bucket_start.end() - 1);
+        gl::parallel_for(count, 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                uint32_t const destination     = std::atomic_ref{_bucket_fill[_buckets[i]]}.fetch_add(1, std::memory_order_relaxed);
+                _sorted_indices[destination]   = static_cast<uint32_t>(i);
+                _sorted_positions[destination] = position_of(i);
+            }
+        });
+    }
+
+    /// Calls `fn(index, position)` for each point whose distance to `position` is at most `radius` (including the point itself, if it is in the grid).
+    /// `radius` should be close to the cell size: the query visits all the cells that overlap the square / cube around `position`. Bigger radii work, but are slower.
+    /// Queries are read-only, so they can run in parallel.
+    template<typename Fn>
+    void for_each_neighbor(Vec const& position, float radius, Fn&& fn) const
+    {
+        if (_sorted_indices.empty())
+            return;
+        auto const min_cell = cell(position - radius);
+        auto const max_cell = cell(position + radius);
+
+        // Several cells can share a bucket, make sure that we visit each bucket only once.
+        // The first buckets are remembered on the stack, and only big queries (e.g. 5x5x5 cells in 3D) need to allocate.
+        auto   visited_buckets  = std::array<uint32_t, 64>{};
+        size_t visited_count    = 0;
+        auto   overflow_buckets = std::vector<uint32_t>{};
+        auto const was_visited  = [&](uint32_t b) {
+            auto const end = visited_buckets.begin() + static_cast<std::ptrdiff_t>(visited_count);
+            return std::find(visited_buckets.begin(), end, b) != end
+                   || std::find(overflow_buckets.begin(), overflow_buckets.end(), b) != overflow_buckets.end();
+        };
+        for_each_cell(min_cell, max_cell, [&](IVec const& c) {
+            uint32_t const b = bucket(c);
+            if (was_visited(b))
+                return;
+            if (visited_count < visited_buckets.size())
+                visited_buckets[visited_count++] = b;
+            else
+                overflow_buckets.push_back(b);
+
+            for (uint32_t i = _bucket_start[b]; i < _bucket_start[b + 1]; ++i)
+            {
+                auto const delta = _sorted_positions[i] - position;
+                if (glm::dot(delta, delta) <= radius * radius)
+                    fn(_sorted_indices[i], _sorted_positions[i]);
+            }
+        });
+    }
+
+    auto cell_size() const -> float { return _cell_size; }
+    auto points_count() const -> size_t { return _sorted_indices.size(); }
+
+private:
+    auto cell(Vec const& position) const -> IVec
+    {
+        return IVec{glm::floor(position / _cell_size)};
+    }
+
+    auto bucket(IVec const& cell) const -> uint32_t
+    {
+        // Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects", 2003
+        constexpr auto primes = std::array<uint32_t, 3>{73856093u, 19349663u, 83492791u};
+        uint32_t       hash   = 0;
+        for (glm::length_t i = 0; i < Dimension; ++i)
+            hash ^= static_cast<uint32_t>(cell[i]) * primes[static_cast<size_t>(i)];
+        return hash & _table_mask;
+    }
+
+    template<typename Fn>
+    static void for_each_cell(IVec const& min_cell, IVec const& max_cell, Fn&& fn)
+    {
+        auto c = min_cell;
+        while (true)
+        {
+            fn(c);
+            // Increment like an odometer
+            glm::length_t i = 0;
+            for (; i < Dimension; ++i)
+            {
+                if (++c[i] <= max_cell[i])
+                    break;
+                c[i] = min_cell[i];
+            }
+            if (i == Dimension)
+                return;
+        }
+    }
+
+private:
+    float                 _cell_size;
+    uint32_t              _table_mask{0};
+    std::vector<uint32_t> _buckets{};
+    std::vector<uint32_t> _bucket_start{}; /// Bucket b contains the points in [_bucket_start[b], _bucket_start[b + 1]) of the sorted arrays
+    std::vector<uint32_t> _bucket_fill{};
+    std::vector<uint32_t> _sorted_indices{};
+    std::vector<Vec>      _sorted_positions{};
+};
+
+using SpatialHash2D = SpatialHash<2>;
+using SpatialHash3D = SpatialHash<3>;
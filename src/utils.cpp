@@ -1,36 +1,50 @@
 #include "utils.hpp"
-#include <random>
+#include <array>
+#include <cstddef>
 #include "opengl-framework/opengl-framework.hpp"
+#include "rng.hpp"
 
 namespace utils {
+struct SquareVertex {
+    glm::vec2 position;
+    glm::vec2 uv;
+};
+} // namespace utils
+
+template<>
+struct gl::VertexDescription<utils::SquareVertex> {
+    static constexpr auto members = std::array{
+        gl::vertex_member<gl::VertexAttribute::Position2D>(0, offsetof(utils::SquareVertex, position)),
+        gl::vertex_member<gl::VertexAttribute::UV>(1, offsetof(utils::SquareVertex, uv)),
+    };
+};
+
+template<>
+struct gl::VertexDescription<utils::Disk> {
+    static constexpr auto members = std::array{
+        gl::vertex_member<gl::VertexAttribute::Position2D>(2, offsetof(utils::Disk, position)),
+        gl::vertex_member<gl::VertexAttribute::Float>(3, offsetof(utils::Disk, radius)),
+        gl::vertex_member<gl::VertexAttribute::ColorRGBA>(4, offsetof(utils::Disk, color)),
+    };
+};
 
-static auto& generator()
-{
-    thread_local std::default_random_engine gen{std::random_device{}()};
-    return gen;
-}
+namespace utils {
 
 float rand(float min, float max)
 {
-    return std::uniform_real_distribution<float>{min, max}(generator());
+    return rng::thread_stream().uniform(min, max);
 }
 
 static auto make_square_mesh() -> gl::Mesh
 {
-    return gl::Mesh{gl::Mesh_Descriptor{
-        .vertex_buffers = {
-            gl::VertexBuffer_Descriptor{
-                .layout = {gl::VertexAttribute::Position2D(0), gl::VertexAttribute::UV(1)},
-                .data   = {
-                    -1.f, -1.f, 0.f, 0.f, //
-                    +1.f, -1.f, 1.f, 0.f, //
-                    +1.f, +1.f, 1.f, 1.f, //
-                    -1.f, +1.f, 0.f, 1.f  //
-                }
-            }
-        },
-        .index_buffer = {0, 1, 2, 0, 2, 3},
-    }};
+    static constexpr auto vertices = std::array{
+        SquareVertex{{-1.f, -1.f}, {0.f, 0.f}},
+        SquareVertex{{+1.f, -1.f}, {1.f, 0.f}},
+        SquareVertex{{+1.f, +1.f}, {1.f, 1.f}},
+        SquareVertex{{-1.f, +1.f}, {0.f, 1.f}},
+    };
+    static constexpr auto indices = std::array<uint32_t, 6>{0, 1, 2, 0, 2, 3};
+    return gl::Mesh::from_vertices<SquareVertex>(vertices, indices);
 }
 
 static auto make_disk_shader() -> gl::Shader
@@ -42,19 +56,23 @@ static auto make_disk_shader() -> gl::Shader
 
 layout(location = 0) in vec2 in_position;
 layout(location = 1) in vec2 in_uv;
+// Per instance
+layout(location = 2) in vec2 in_disk_position;
+layout(location = 3) in float in_disk_radius;
+layout(location = 4) in vec4 in_disk_color;
 
-uniform vec2 u_position;
-uniform float u_radius;
 uniform float u_inverse_aspect_ratio;
 
 out vec2 v_uv;
+out vec4 v_color;
 
 void main()
 {
-    vec2 position = u_position + u_radius * in_position;
+    vec2 position = in_disk_position + in_disk_radius * in_position;
 
     gl_Position = vec4(position * vec2(u_inverse_aspect_ratio, 1.), 0., 1.);
     v_uv = in_uv;
+    v_color = in_disk_color;
 }
 )GLSL"}),
             .fragment = gl::ShaderSource::Code({R"GLSL(
@@ -63,31 +81,39 @@ void main()
 out vec4 out_color;
 
 in vec2 v_uv;
-uniform vec4 u_color;
+in vec4 v_color;
 
 void main()
 {
     vec2 dir = v_uv - vec2(0.5);
     if (dot(dir, dir) > 0.25)
         discard;
-    out_color = u_color;
+    out_color = v_color;
 }
 )GLSL"}),
         }
     };
 }
 
-void draw_disk(glm::vec2 position, float radius, glm::vec4 const& color)
+void draw_disks(std::span<Disk const> disks)
 {
-    static auto square_mesh = make_square_mesh();
+    static auto disk_mesh = []() {
+        auto mesh = make_square_mesh();
+        mesh.add_instance_buffer<Disk>();
+        return mesh;
+    }();
     static auto disk_shader = make_disk_shader();
 
+    disk_mesh.update_instance_buffer<Disk>(0, disks);
     disk_shader.bind();
-    disk_shader.set_uniform("u_position", position);
-    disk_shader.set_uniform("u_radius", radius);
     disk_shader.set_uniform("u_inverse_aspect_ratio", 1.f / gl::framebuffer_aspect_ratio());
-    disk_shader.set_uniform("u_color", color);
-    square_mesh.draw();
+    disk_mesh.draw_instanced(static_cast<GLsizei>(disks.size()));
+}
+
+void draw_disk(glm::vec2 position, float radius, glm::vec4 const& color)
+{
+    auto const disk = Disk{.position = position, .radius = radius, .color = color};
+    draw_disks({&disk, 1});
 }
 
 static auto make_line_shader() -> gl::Shader
@@ -1,10 +1,20 @@
 #pragma once
+#include <span>
 #include "glm/glm.hpp"
 
 namespace utils {
 
+struct Disk {
+    glm::vec2 position;
+    float     radius;
+    glm::vec4 color;
+};
+
+/// Uniform in [min, max). Uses rng::thread_stream(): prefer your own rng::Stream and its fill_uniform() when you need a lot of numbers.
 float rand(float min, float max);
 void  draw_disk(glm::vec2 position, float radius, glm::vec4 const& color);
+/// Draws all the disks with a single draw call
+void  draw_disks(std::span<Disk const> disks);
 void  draw_line(glm::vec2 start, glm::vec2 end, float thickness, glm::vec4 const& color);
 
 } // namespace utils
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "img/img.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+
+// Converts PNG images into block-compressed .ktx2 files that can be loaded with gl::TextureSource::CompressedFile.
+// Usage: CompressTextures [--bc4 | --bc5 | --bc7 | --bc7-srgb] [--no-mipmaps] [--no-flip] [--threads N] [files or folders...]
+// By default, all the PNGs in the "res" folder are compressed to BC7, and each .ktx2 file is written next to its PNG.
+
+namespace {
+
+struct Options {
+    gl::Compression_Options            compression{};
+    bool                               flip_y{true};
+    std::vector<std::filesystem::path> inputs{};
+};
+
+auto parse_options(int argc, char** argv) -> Options
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (arg == "--bc4")
+            options.compression.format = gl::CompressionFormat::BC4;
+        else if (arg == "--bc5")
+            options.compression.format = gl::CompressionFormat::BC5;
+        else if (arg == "--bc7")
+            options.compression.format = gl::CompressionFormat::BC7;
+        else if (arg == "--bc7-srgb")
+            options.compression.format = gl::CompressionFormat::BC7_SRGB;
+        else if (arg == "--no-mipmaps")
+            options.compression.generate_mipmaps = false;
+        else if (arg == "--no-flip")
+            options.flip_y = false;
+        else if (arg == "--threads" && i + 1 < argc)
+            gl::set_threads_count(static_cast<unsigned int>(std::stoul(argv[++i])));
+        else
+            options.inputs.emplace_back(arg);
+    }
+    if (options.inputs.empty())
+        options.inputs.emplace_back("res");
+    return options;
+}
+
+auto collect_images(std::vector<std::filesystem::path> const& inputs) -> std::vector<std::filesystem::path>
+{
+    auto images = std::vector<std::filesystem::path>{};
+    for (auto const& input : inputs)
+    {
+        if (std::filesystem::is_directory(input))
+        {
+            for (auto const& entry : std::filesystem::recursive_directory_iterator{input})
+            {
+                if (entry.is_regular_file() && entry.path().extension() == ".png")
+                    images.push_back(entry.path());
+            }
+        }
+        else
+        {
+            images.push_back(input);
+        }
+    }
+    return images;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto const options = parse_options(argc, argv);
+    auto const images  = collect_images(options.inputs);
+    if (images.empty())
+        std::cout << "No image to compress.\n";
+
+    int errors_count = 0;
+    for (auto const& path : images)
+    {
+        try
+        {
+            auto const start      = std::chrono::steady_clock::now();
+            auto const image      = img::load(path, 4, options.flip_y);
+            auto const compressed = gl::compress_image(image.data_span(), static_cast<GLsizei>(image.width()), static_cast<GLsizei>(image.height()), options.compression);
+            auto       output     = path;
+            output.replace_extension(".ktx2");
+            gl::save_ktx2(output, compressed);
+
+            auto const duration = std::chrono::duration<float, std::milli>{std::chrono::steady_clock::now() - start};
+            std::cout << path.string() << " -> " << output.string() << " (" << compressed.levels.size() << " mips, " << duration.count() << " ms)\n";
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "Failed to compress " << path.string() << ": " << e.what() << '\n';
+            ++errors_count;
+        }
+    }
+    return errors_count == 0 ? 0 : 1;
+}